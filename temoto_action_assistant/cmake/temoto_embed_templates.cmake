@@ -0,0 +1,70 @@
+# Embeds file templates into a binary as constant string tables, so that the templates do
+# not have to be located and read at runtime.
+#
+#   temoto_embed_templates(<output_cpp> <table_name> <template files>...)
+#
+# generates <output_cpp> which defines
+#
+#   extern const temoto_action_assistant::EmbeddedTemplateTable <table_name>;
+#
+# The templates are keyed by their file name. The generated file is regenerated whenever
+# one of the templates changes.
+
+if(CMAKE_SCRIPT_MODE_FILE AND TEMOTO_EMBED_OUTPUT)
+  # Script mode: invoked by the custom command below
+  set(DELIMITER "ta_template")
+  set(LITERALS "")
+  set(ENTRIES "")
+  set(INDEX 0)
+
+  string(REPLACE "|" ";" TEMPLATE_FILES "${TEMOTO_EMBED_FILES}")
+  foreach(TEMPLATE_FILE ${TEMPLATE_FILES})
+    get_filename_component(TEMPLATE_NAME ${TEMPLATE_FILE} NAME)
+    file(READ ${TEMPLATE_FILE} TEMPLATE_CONTENT)
+
+    string(FIND "${TEMPLATE_CONTENT}" ")${DELIMITER}\"" DELIMITER_POS)
+    if(NOT DELIMITER_POS EQUAL -1)
+      message(FATAL_ERROR "Template ${TEMPLATE_FILE} contains the raw string delimiter ')${DELIMITER}\"'")
+    endif()
+
+    string(APPEND LITERALS "constexpr char template_${INDEX}[] = R\"${DELIMITER}(${TEMPLATE_CONTENT})${DELIMITER}\";\n\n")
+    string(APPEND ENTRIES "  {\"${TEMPLATE_NAME}\", template_${INDEX}, sizeof(template_${INDEX}) - 1},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+  endforeach()
+
+  file(WRITE ${TEMOTO_EMBED_OUTPUT}.tmp
+    "// Generated by temoto_embed_templates.cmake, do not edit\n"
+    "#include \"temoto_action_assistant/embedded_templates.h\"\n\n"
+    "namespace\n{\n"
+    "${LITERALS}"
+    "const temoto_action_assistant::EmbeddedTemplate templates[] = {\n"
+    "${ENTRIES}"
+    "};\n"
+    "} // anonymous namespace\n\n"
+    "extern const temoto_action_assistant::EmbeddedTemplateTable ${TEMOTO_EMBED_TABLE};\n"
+    "const temoto_action_assistant::EmbeddedTemplateTable ${TEMOTO_EMBED_TABLE} = {templates, ${INDEX}};\n")
+
+  # Only touch the output if the content changed, to avoid needless recompilation
+  execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${TEMOTO_EMBED_OUTPUT}.tmp ${TEMOTO_EMBED_OUTPUT})
+  file(REMOVE ${TEMOTO_EMBED_OUTPUT}.tmp)
+  return()
+endif()
+
+set(TEMOTO_EMBED_TEMPLATES_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+function(temoto_embed_templates OUTPUT_CPP TABLE_NAME)
+  set(TEMPLATE_FILES ${ARGN})
+  string(REPLACE ";" "|" TEMPLATE_FILES_ARG "${TEMPLATE_FILES}")
+
+  add_custom_command(
+    OUTPUT ${OUTPUT_CPP}
+    COMMAND ${CMAKE_COMMAND}
+      -DTEMOTO_EMBED_OUTPUT=${OUTPUT_CPP}
+      -DTEMOTO_EMBED_TABLE=${TABLE_NAME}
+      "-DTEMOTO_EMBED_FILES=${TEMPLATE_FILES_ARG}"
+      -P ${TEMOTO_EMBED_TEMPLATES_SCRIPT}
+    DEPENDS ${TEMPLATE_FILES} ${TEMOTO_EMBED_TEMPLATES_SCRIPT}
+    COMMENT "Embedding file templates into ${TABLE_NAME}"
+    VERBATIM
+  )
+endfunction()
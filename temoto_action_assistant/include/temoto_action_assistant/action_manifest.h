@@ -0,0 +1,147 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__ACTION_MANIFEST_H
+#define TEMOTO_ACTION_ASSISTANT__ACTION_MANIFEST_H
+
+#include "temoto_action_engine/umrf_node.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief Name of the binary action manifest in the root of an actions directory. The manifest
+ * lists every generated action, so that the actions can be discovered by reading a single file
+ * instead of searching the directory tree for UMRFs.
+ */
+extern const std::string ACTION_MANIFEST_FILE_NAME;
+
+struct ActionManifestParameter
+{
+  std::string name;
+  std::string type;
+  bool input;
+};
+
+struct ActionManifestEntry
+{
+  std::string package_name;
+  std::string class_name;
+
+  /// Path of the action library relative to the install space, as in bundle_manifest.json
+  std::string library_path;
+
+  /// Path of the UMRF, relative to the actions directory
+  std::string umrf_path;
+
+  /// FNV-1a hash of the UMRF JSON
+  std::uint64_t umrf_hash;
+
+  /// Input and output parameters in the order of the UMRF
+  std::vector<ActionManifestParameter> parameters;
+
+  /// The UMRF JSON itself, so that the UMRF can be restored without reading umrf_path
+  std::string umrf_json;
+};
+
+std::uint64_t hashUmrfJson(const std::string& umrf_json);
+
+/**
+ * @brief Creates the manifest entries of a generated package
+ * @param umrfs UMRFs of the package, a regular package has exactly one
+ * @param package_name Name of the generated package
+ * @param bundle Whether the package is a bundle. As in the bundle itself, UMRFs with a
+ * class name that is already taken are skipped.
+ */
+std::vector<ActionManifestEntry> makeActionManifestEntries(const std::vector<UmrfNode>& umrfs
+, const std::string& package_name
+, bool bundle);
+
+/**
+ * @brief Encodes the entries in the binary manifest format:
+ *
+ *   header   "TAMF", format version (u32), entry count (u32)
+ *   entry    package name, class name, library path, UMRF path, UMRF hash (u64),
+ *            parameter count (u32), parameters, UMRF JSON
+ *   param    direction (u8, 1 = input), name, type
+ *
+ * Strings are stored as a u32 length followed by the characters, all integers are
+ * little-endian.
+ */
+std::string encodeActionManifest(const std::vector<ActionManifestEntry>& entries);
+
+/**
+ * @brief Throws std::runtime_error if the data is not a valid manifest
+ */
+std::vector<ActionManifestEntry> decodeActionManifest(const char* data, std::size_t size);
+
+/**
+ * @brief Replaces the manifest of the actions directory. The manifest is written to a temporary
+ * file that is renamed over the old one, hence readers see either the old or the new manifest.
+ */
+void writeActionManifest(const std::string& actions_path, const std::vector<ActionManifestEntry>& entries);
+
+/**
+ * @brief Adds the entries to the manifest of the actions directory. Existing entries of the same
+ * libraries are replaced, e.g. all entries of a regenerated bundle. Concurrent updates are
+ * serialized with a lock file next to the manifest.
+ */
+void updateActionManifest(const std::string& actions_path, const std::vector<ActionManifestEntry>& entries);
+
+/**
+ * @brief Read-only memory mapping of the manifest of an actions directory. The manifest is
+ * mapped by the first call to refresh().
+ */
+class MappedActionManifest
+{
+public:
+  explicit MappedActionManifest(const std::string& actions_path);
+  ~MappedActionManifest();
+
+  MappedActionManifest(const MappedActionManifest&) = delete;
+  MappedActionManifest& operator=(const MappedActionManifest&) = delete;
+
+  /**
+   * @brief Maps the manifest again if it has been replaced since the last call
+   * @return true if the mapping has changed, i.e., the entries have to be decoded again
+   */
+  bool refresh();
+
+  /**
+   * @brief Whether the actions directory has a manifest
+   */
+  bool exists() const;
+
+  /**
+   * @brief Decodes the mapped manifest. Throws std::runtime_error if it is not valid.
+   */
+  std::vector<ActionManifestEntry> getEntries() const;
+
+private:
+  void unmap();
+
+  std::string manifest_path_;
+  const char* data_;
+  std::size_t size_;
+  std::uint64_t inode_;
+  std::int64_t modification_time_ns_;
+  bool exists_;
+};
+
+} // temoto_action_assistant namespace
+#endif
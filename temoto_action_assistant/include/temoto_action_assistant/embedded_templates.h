@@ -0,0 +1,73 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__EMBEDDED_TEMPLATES_H
+#define TEMOTO_ACTION_ASSISTANT__EMBEDDED_TEMPLATES_H
+
+#include "temoto_action_assistant/template_engine.h"
+#include <cstddef>
+#include <string>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief A file template that is compiled into the binary, see temoto_embed_templates.cmake
+ */
+struct EmbeddedTemplate
+{
+  const char* name;
+  const char* content;
+  std::size_t size;
+};
+
+struct EmbeddedTemplateTable
+{
+  const EmbeddedTemplate* templates;
+  std::size_t count;
+
+  /**
+   * @brief Returns the template with the given file name or nullptr
+   */
+  const EmbeddedTemplate* find(const std::string& name) const;
+};
+
+/**
+ * @brief Loads file templates from an optional override directory and falls back to the
+ * templates that are embedded into the binary.
+ */
+class TemplateLoader
+{
+public:
+  /**
+   * @param embedded_templates Templates that are compiled into the binary
+   * @param override_path Directory whose templates take precedence over the embedded ones.
+   * Empty if the embedded templates are used as is.
+   */
+  TemplateLoader(const EmbeddedTemplateTable& embedded_templates, const std::string& override_path = "");
+
+  /**
+   * @brief Parses the template with the given file name. Throws std::runtime_error if the
+   * template is neither found in the override directory nor embedded.
+   */
+  CompiledTemplate load(const std::string& name) const;
+
+private:
+  const EmbeddedTemplateTable& embedded_templates_;
+  std::string override_path_;
+};
+
+} // temoto_action_assistant namespace
+#endif
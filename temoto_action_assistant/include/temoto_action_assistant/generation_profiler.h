@@ -0,0 +1,117 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__GENERATION_PROFILER_H
+#define TEMOTO_ACTION_ASSISTANT__GENERATION_PROFILER_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief Collects the durations of the package generation stages. Timers are recorded from
+ * any thread, each one is attributed to the package that is being generated by that thread.
+ */
+class GenerationProfiler
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Event
+  {
+    std::string stage;
+    std::string package;
+    std::string detail;
+    Clock::time_point start;
+    Clock::duration duration;
+    unsigned int thread_index;
+  };
+
+  /**
+   * @brief Measures the time from construction to destruction. Does nothing if the
+   * profiler is nullptr, hence generation code can be instrumented unconditionally.
+   */
+  class ScopedTimer
+  {
+  public:
+    ScopedTimer(GenerationProfiler* profiler, const char* stage, const std::string& detail = "");
+    ~ScopedTimer();
+
+    /**
+     * @brief Records the time measured so far. The timer records nothing after that.
+     */
+    void stop();
+
+  private:
+    GenerationProfiler* profiler_;
+    const char* stage_;
+    std::string detail_;
+    Clock::time_point start_;
+  };
+
+  /**
+   * @brief Attributes all timers of the calling thread to a package until the scope ends.
+   * The whole scope is recorded as the "package" stage.
+   */
+  class PackageScope
+  {
+  public:
+    PackageScope(GenerationProfiler* profiler, const std::string& package_name);
+    ~PackageScope();
+
+  private:
+    const std::string* previous_package_;
+    std::string package_name_;
+    ScopedTimer timer_;
+  };
+
+  GenerationProfiler();
+
+  void clear();
+
+  std::vector<Event> getEvents() const;
+
+  /**
+   * @brief Aggregated report with the time spent per stage, per template and the slowest
+   * packages
+   * @param max_rows Maximum number of rows in each of the "slowest" tables
+   */
+  std::string formatReport(std::size_t max_rows = 10) const;
+
+  /**
+   * @brief Events in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+   */
+  std::string toChromeTrace() const;
+
+  bool writeChromeTrace(const std::string& file_path) const;
+
+private:
+  void record(const char* stage, const std::string& detail, Clock::time_point start, Clock::time_point end);
+
+  unsigned int getThreadIndex();
+
+  Clock::time_point created_;
+  mutable std::mutex events_mutex_;
+  std::vector<Event> events_;
+  std::vector<std::pair<std::thread::id, unsigned int>> thread_indices_;
+};
+
+} // temoto_action_assistant namespace
+#endif
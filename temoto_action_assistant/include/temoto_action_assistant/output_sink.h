@@ -0,0 +1,177 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__OUTPUT_SINK_H
+#define TEMOTO_ACTION_ASSISTANT__OUTPUT_SINK_H
+
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief Destination of the generated files. Paths are relative to the root of the sink
+ * and use "/" as the separator. Files are written one at a time: beginFile returns a
+ * stream that stays valid until the matching endFile call.
+ */
+class OutputSink
+{
+public:
+  /**
+   * @brief Size that is passed to beginFile when the size of the file is not known upfront
+   */
+  static const std::size_t UNKNOWN_SIZE;
+
+  virtual ~OutputSink() = default;
+
+  virtual void createDirectory(const std::string& path) = 0;
+
+  /**
+   * @brief Starts a new file and returns the stream where its content is written to
+   * @param path Path of the file
+   * @param size Exact number of bytes that are going to be written, or UNKNOWN_SIZE
+   */
+  virtual std::ostream& beginFile(const std::string& path, std::size_t size) = 0;
+
+  virtual void endFile() = 0;
+
+  /**
+   * @brief Writes a file whose content is already in memory
+   */
+  void writeFile(const std::string& path, const std::string& content);
+};
+
+/**
+ * @brief Writes the files to the filesystem under a base directory
+ */
+class FileSystemSink : public OutputSink
+{
+public:
+  explicit FileSystemSink(const std::string& base_path);
+
+  void createDirectory(const std::string& path) override;
+  std::ostream& beginFile(const std::string& path, std::size_t size) override;
+  void endFile() override;
+
+private:
+  std::string base_path_;
+  std::ofstream file_;
+};
+
+/**
+ * @brief Keeps the files in memory, e.g. for validating the generated packages or for
+ * comparing them against the ones on disk.
+ */
+class MemorySink : public OutputSink
+{
+public:
+  MemorySink();
+
+  void createDirectory(const std::string& path) override;
+  std::ostream& beginFile(const std::string& path, std::size_t size) override;
+  void endFile() override;
+
+  /**
+   * @brief Files sorted by path
+   */
+  const std::map<std::string, std::string>& getFiles() const;
+
+  const std::set<std::string>& getDirectories() const;
+
+  /**
+   * @brief Returns the content of a file or nullptr if the file does not exist
+   */
+  const std::string* findFile(const std::string& path) const;
+
+private:
+  /*
+   * Stream buffer that appends directly to the content of the current file
+   */
+  class StringAppendBuf : public std::streambuf
+  {
+  public:
+    std::string* target = nullptr;
+
+  protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+  };
+
+  std::map<std::string, std::string> files_;
+  std::set<std::string> directories_;
+  StringAppendBuf buffer_;
+  std::ostream stream_;
+};
+
+/**
+ * @brief Streams the files into a POSIX ustar archive. A file whose size is known when it
+ * is started is written straight through to the archive stream. The entry header holds the
+ * size, hence a file of UNKNOWN_SIZE is buffered until endFile. The archive is terminated
+ * by finish() or by the destructor.
+ */
+class TarSink : public OutputSink
+{
+public:
+  explicit TarSink(std::ostream& archive);
+  ~TarSink();
+
+  void createDirectory(const std::string& path) override;
+  std::ostream& beginFile(const std::string& path, std::size_t size) override;
+  void endFile() override;
+
+  /**
+   * @brief Writes the end-of-archive marker. No files can be added afterwards.
+   */
+  void finish();
+
+private:
+  /*
+   * Stream buffer that forwards to the archive and counts the bytes of the current file
+   */
+  class CountingBuf : public std::streambuf
+  {
+  public:
+    std::streambuf* target = nullptr;
+    std::size_t count = 0;
+
+  protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+  };
+
+  void writeHeader(const std::string& path, std::size_t size, char type_flag);
+  void writePadding(std::size_t size);
+
+  std::ostream& archive_;
+  CountingBuf buffer_;
+  std::ostream stream_;
+  std::set<std::string> written_directories_;
+  std::size_t file_size_;
+  bool finished_;
+
+  // File of unknown size that is buffered until endFile
+  bool buffering_;
+  std::string buffered_path_;
+  std::ostringstream buffered_content_;
+};
+
+} // temoto_action_assistant namespace
+#endif
@@ -0,0 +1,65 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__PACKAGE_DIFF_H
+#define TEMOTO_ACTION_ASSISTANT__PACKAGE_DIFF_H
+
+#include "temoto_action_assistant/output_sink.h"
+#include <string>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief A generated file that differs from its counterpart on disk
+ */
+struct FileChange
+{
+  enum class Type
+  {
+    ADDED,
+    MODIFIED
+  };
+
+  Type type;
+  std::string path;
+  std::string diff;
+};
+
+/**
+ * @brief Creates a line based diff in the unified format. Returns an empty string if the
+ * contents are equal.
+ *
+ * @param old_content Content of the original file
+ * @param new_content Content of the changed file
+ * @param old_label Name of the original file in the "---" line
+ * @param new_label Name of the changed file in the "+++" line
+ * @param context_lines Number of unchanged lines that are shown around each change
+ */
+std::string makeUnifiedDiff(const std::string& old_content
+, const std::string& new_content
+, const std::string& old_label
+, const std::string& new_label
+, unsigned int context_lines = 3);
+
+/**
+ * @brief Compares the files of the sink against the files under base_path
+ * @return Files that would be added or modified if the sink was written to base_path
+ */
+std::vector<FileChange> diffAgainstDisk(const MemorySink& sink, const std::string& base_path);
+
+} // temoto_action_assistant namespace
+#endif
@@ -0,0 +1,134 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__PACKAGE_REGENERATOR_H
+#define TEMOTO_ACTION_ASSISTANT__PACKAGE_REGENERATOR_H
+
+#include "temoto_action_assistant/ta_package_generator.h"
+#include "temoto_action_assistant/package_diff.h"
+#include <string>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief An existing package in the actions directory, either a regular action package
+ * (described by "umrf.json") or a bundle (described by "bundle_manifest.json")
+ */
+struct GenerationJob
+{
+  std::string package_name;
+  std::vector<UmrfNode> umrfs;
+  bool bundle;
+};
+
+struct DryRunReport
+{
+  std::size_t package_count = 0;
+  std::size_t file_count = 0;
+  double duration_ms = 0;
+
+  /// Changed files of all packages, sorted by path
+  std::vector<FileChange> changes;
+
+  /// Packages that could not be read or generated, and UMRFs that were skipped
+  std::vector<std::string> errors;
+};
+
+struct WriteReport
+{
+  /// Number of files that were created or changed
+  std::size_t written_count = 0;
+
+  /// Regenerated versions of edited user files, saved next to them with a ".new" suffix
+  std::vector<std::string> new_files;
+
+  /// Packages that could not be generated, and UMRFs that were skipped
+  std::vector<std::string> warnings;
+};
+
+/**
+ * @brief Regenerates all packages of an actions directory from their UMRFs, e.g. after
+ * the file templates have changed.
+ */
+class PackageRegenerator
+{
+public:
+  /**
+   * @brief Indexes the packages in the actions directory
+   * @param apg Generator that is used for regenerating the packages
+   * @param actions_path Directory that contains the action packages
+   */
+  PackageRegenerator(const ActionPackageGenerator& apg, const std::string& actions_path);
+
+  const std::vector<GenerationJob>& getJobs() const;
+
+  /**
+   * @brief Regenerates all packages into the sink, e.g. an archive. Every file is written,
+   * use writeInPlace for regenerating the packages in the actions directory.
+   * @return Warnings about the UMRFs that were skipped, e.g. duplicate classes in a bundle
+   */
+  std::vector<std::string> regenerate(OutputSink& sink) const;
+
+  /**
+   * @brief Regenerates all packages in the actions directory. Only the files that changed are
+   * written. The files that users edit (see isUserFile) are never overwritten, if their
+   * regenerated version differs, it is written next to them as "<path>.new".
+   */
+  WriteReport writeInPlace() const;
+
+  /**
+   * @brief Returns true for the files of a package that users are expected to edit: the
+   * action sources in "src/", "CMakeLists.txt" and "package.xml"
+   * @param path Path relative to the actions directory, e.g. "ta_foo/src/ta_foo.cpp"
+   */
+  static bool isUserFile(const std::string& path);
+
+  /**
+   * @brief Rewrites the action manifest of the actions directory from all packages, e.g.
+   * after regenerating the packages in place. Packages that are no longer in the directory
+   * are dropped from the manifest.
+   */
+  void writeManifest() const;
+
+  /**
+   * @brief Renders all packages into memory in parallel and compares them against the
+   * packages on disk. Nothing is written to disk.
+   *
+   * @param thread_count Number of worker threads, 0 uses all hardware threads
+   */
+  DryRunReport dryRun(unsigned int thread_count = 0) const;
+
+  /**
+   * @brief Formats the report as text
+   * @param include_diffs If false, only the paths of the changed files are listed
+   */
+  static std::string formatReport(const DryRunReport& report, bool include_diffs = true);
+
+private:
+  /**
+   * @brief Generates the package of the job, returns the warnings about skipped UMRFs
+   */
+  std::vector<std::string> generate(const GenerationJob& job, OutputSink& sink) const;
+
+  const ActionPackageGenerator& apg_;
+  std::string actions_path_;
+  std::vector<GenerationJob> jobs_;
+  std::vector<std::string> index_errors_;
+};
+
+} // temoto_action_assistant namespace
+#endif
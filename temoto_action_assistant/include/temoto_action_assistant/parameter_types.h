@@ -0,0 +1,90 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__PARAMETER_TYPES_H
+#define TEMOTO_ACTION_ASSISTANT__PARAMETER_TYPES_H
+
+#include <string>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief UMRF parameter types with this prefix, e.g. "shared:sensor_msgs::PointCloud2", are
+ * passed between actions as shared immutable buffers (std::shared_ptr<const T>). Handing
+ * such a parameter from one action to the next only increments a reference count.
+ */
+extern const std::string SHARED_TYPE_PREFIX;
+
+bool isSharedType(const std::string& parameter_type);
+
+/**
+ * @brief Creates the UMRF type of a shared buffer of the given C++ type
+ */
+std::string toSharedType(const std::string& cpp_type);
+
+/**
+ * @brief Returns the type of the buffer of a shared type, e.g. "sensor_msgs::PointCloud2"
+ */
+std::string getSharedType(const std::string& shared_type);
+
+/**
+ * @brief UMRF parameter types with this prefix, e.g. "topic:sensor_msgs::LaserScan", hold the
+ * name of a ROS topic. The generated action subscribes to the topic and receives the messages
+ * through a lock-free channel.
+ */
+extern const std::string TOPIC_TYPE_PREFIX;
+
+bool isTopicType(const std::string& parameter_type);
+
+/**
+ * @brief Creates the UMRF type of a topic of the given ROS message type
+ */
+std::string toTopicType(const std::string& message_type);
+
+/**
+ * @brief Returns the ROS message type of a topic type, e.g. "sensor_msgs::LaserScan"
+ */
+std::string getMessageType(const std::string& topic_type);
+
+/**
+ * @brief Whether the C++ type is a ROS message, i.e., "<package>::<message>" where the name of
+ * the package ends with "_msgs", e.g. "sensor_msgs::PointCloud2"
+ */
+bool isMessageType(const std::string& cpp_type);
+
+/**
+ * @brief Returns the header of a ROS message type, e.g. "sensor_msgs/LaserScan.h"
+ */
+std::string getMessageHeader(const std::string& message_type);
+
+/**
+ * @brief Returns the package of a ROS message type, e.g. "sensor_msgs"
+ */
+std::string getMessagePackage(const std::string& message_type);
+
+/**
+ * @brief Whether the generated binary parameter codecs can encode the parameter type
+ */
+bool hasBinaryEncoding(const std::string& parameter_type);
+
+/**
+ * @brief Returns the C++ type that corresponds to the UMRF parameter type. Types that are not
+ * in the action engine's parameter map are assumed to be C++ types already.
+ */
+std::string toCppType(const std::string& parameter_type);
+
+} // temoto_action_assistant namespace
+#endif
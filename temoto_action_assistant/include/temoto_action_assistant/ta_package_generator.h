@@ -17,44 +17,223 @@
 #ifndef TEMOTO_ACTION_ENGINE__TA_PACKAGE_GENERATOR_H
 #define TEMOTO_ACTION_ENGINE__TA_PACKAGE_GENERATOR_H
 
-#include "file_template_parser/file_template_parser.h"
+#include "temoto_action_assistant/generation_profiler.h"
+#include "temoto_action_assistant/output_sink.h"
+#include "temoto_action_assistant/template_engine.h"
 #include "temoto_action_engine/umrf_node.h"
 #include "temoto_action_engine/umrf_graph.h"
 #include "temoto_action_engine/umrf_json_converter.h"
+#include <map>
+#include <set>
 
 namespace temoto_action_assistant
 {
+/**
+ * @brief Determines how the CMakeLists.txt of a generated package is set up. DEFAULT
+ * uses the default compiler flags, FAST_BUILD precompiles the bridge header, enables
+ * opt-in unity builds and a tuned Release configuration (-O2, LTO).
+ */
+enum class BuildProfile
+{
+  DEFAULT,
+  FAST_BUILD
+};
+
+/**
+ * @brief Converts "default" or "fast" to a BuildProfile. Throws std::invalid_argument
+ * if the name is not recognized.
+ */
+BuildProfile toBuildProfile(const std::string& build_profile_name);
+
 class ActionPackageGenerator
 {
 public:
-  ActionPackageGenerator(const std::string& file_template_path);
-  void generatePackage(const UmrfNode& umrf, const std::string& package_path);
-  void generateGraph(const UmrfGraph& umrf_graph, const std::string& graphs_path);
+  /**
+   * @param template_override_path Optional directory with file templates that override the
+   * templates which are embedded into the binary
+   * @param build_profile Build profile of the generated packages
+   */
+  ActionPackageGenerator(const std::string& template_override_path = ""
+  , BuildProfile build_profile = BuildProfile::DEFAULT);
+
+  /**
+   * @brief Returns false if the file templates could not be loaded, nothing is generated then
+   */
+  bool fileTemplatesLoaded() const;
+
+  /**
+   * @brief Returns the reason why the file templates could not be loaded
+   */
+  const std::string& getTemplateLoadError() const;
+
+  /**
+   * @brief Generates the package into the actions directory "package_path" and adds the
+   * action to the manifest of the directory (see action_manifest.h)
+   */
+  void generatePackage(const UmrfNode& umrf, const std::string& package_path) const;
+
+  /**
+   * @brief Generates the package into an output sink, under the "<package name>/" directory.
+   * If the effect of the UMRF is "asynchronous", the action is written as a start function and
+   * continuations, the execution still holds the engine thread until a continuation completes
+   * it. If the UMRF has a "tick_rate" input parameter of type "number", the action gets a
+   * fixed-rate onTick loop instead of a free-form execute. If the UMRF has a "temoto_batch"
+   * input parameter of type "bool", which only serves as a marker, the action can also be
+   * executed for a batch of input sets in a single call. A marker of any other type is
+   * ignored with a warning and the action gets a blocking execute.
+   */
+  void generatePackage(const UmrfNode& umrf, OutputSink& sink) const;
+
+  void generateGraph(const UmrfGraph& umrf_graph, const std::string& graphs_path) const;
+
+  void generateGraph(const UmrfGraph& umrf_graph, OutputSink& sink, const std::string& graphs_dir) const;
+
+  /**
+   * @brief Generates a single package that builds the actions of all given UMRFs into
+   * one shared library. Each action gets its own source file and CLASS_LOADER_REGISTER_CLASS
+   * entry, and "bundle_manifest.json" maps every UMRF to its class in the bundle.
+   *
+   * @param umrfs UMRFs of the actions that are bundled
+   * @param bundle_name Name of the generated bundle package
+   * @param package_path Base path where the bundle package is generated to. The bundled
+   * actions are added to the manifest of this directory.
+   * @return Package names of the UMRFs that were skipped, because the bundle already contains
+   * a class with the same name
+   */
+  std::vector<std::string> generateBundle(const std::vector<UmrfNode>& umrfs
+  , const std::string& bundle_name
+  , const std::string& package_path) const;
+
+  std::vector<std::string> generateBundle(const std::vector<UmrfNode>& umrfs
+  , const std::string& bundle_name
+  , OutputSink& sink) const;
+
+  /**
+   * @brief Records the duration of each generation stage to the profiler. Profiling is
+   * disabled if the profiler is nullptr, which is the default.
+   */
+  void setProfiler(GenerationProfiler* profiler);
+
+  GenerationProfiler* getProfiler() const;
 
 private:
-  std::string file_template_path_;
+  /*
+   * Variant of the generated action class
+   */
+  enum class ActionVariant
+  {
+    BLOCKING,
+    ASYNC,
+    TICK,
+    BATCH
+  };
+
+  /*
+   * Marker parameters of the wrong type are ignored, in which case the action falls back to
+   * the blocking variant. The reason is printed if report_warnings is true.
+   */
+  static ActionVariant getActionVariant(const UmrfNode& umrf, bool report_warnings = false);
+
+  TemplateArguments makeActionArguments(const UmrfNode& umrf, const std::string& header_package_name) const;
+
+  void generateActionSource(const UmrfNode& umrf
+  , const std::string& header_package_name
+  , OutputSink& sink
+  , const std::string& dst_path) const;
+
+  /**
+   * @brief Generates the binary parameter codec of the action if all its parameter types can
+   * be encoded
+   * @return Include path of the codec header, or an empty string if no codec was generated
+   */
+  std::string generateCodec(const UmrfNode& umrf
+  , const std::string& header_package_name
+  , OutputSink& sink
+  , const std::string& include_path) const;
+
+  /**
+   * @param parameter_types UMRF and C++ types of all parameters in the package, the header
+   * assigns an ID to each of them
+   * @param variants Variants of the actions in the package, the header provides their base classes
+   */
+  void generateBridgeHeader(const std::string& package_name
+  , const std::map<std::string, std::string>& parameter_types
+  , const std::set<ActionVariant>& variants
+  , OutputSink& sink
+  , const std::string& dst_path) const;
+
+  void generateInvokerGraph(const UmrfNode& umrf, OutputSink& sink, const std::string& dst_path) const;
+
+  /**
+   * @brief Generates the microbenchmark "bench/<ta_package_name>_bench.cpp"
+   * @param umrf The action, the benchmark synthesizes input values for its parameter types
+   */
+  void generateBench(const UmrfNode& umrf
+  , const std::string& codec_header
+  , OutputSink& sink
+  , const std::string& dst_path) const;
+
+  /**
+   * @brief Generates the load test driver "test/<ta_package_name>_load_test.cpp" and its
+   * launch file
+   * @param package_name Package that contains the action, i.e., the bundle for bundled actions
+   */
+  void generateLoadTest(const std::string& package_name
+  , const std::string& ta_package_name
+  , const std::string& ta_class_name
+  , OutputSink& sink
+  , const std::string& dst_path) const;
+
+  /**
+   * @brief Generates CMakeLists.txt and package.xml
+   * @param message_packages Packages of the ROS messages of the topic parameters
+   */
+  void generateBuildFiles(const std::string& package_name
+  , const std::vector<std::string>& sources
+  , const std::set<std::string>& message_packages
+  , OutputSink& sink
+  , const std::string& dst_path) const;
+
+  /**
+   * @brief Renders the template straight into the sink. The file extension is taken
+   * from the template.
+   */
+  void saveTemplate(const CompiledTemplate& file_template
+  , const TemplateArguments& args
+  , OutputSink& sink
+  , const std::string& file_path) const;
+
+  void writeJson(OutputSink& sink, const std::string& file_path, const UmrfNode& umrf) const;
+
+  /**
+   * @brief Adds the actions of a package that was generated into the actions directory
+   * to the action manifest of the directory
+   */
+  void updateManifest(const std::string& actions_path
+  , const std::vector<UmrfNode>& umrfs
+  , const std::string& package_name
+  , bool bundle) const;
+
   bool file_templates_loaded_;
+  std::string template_load_error_;
+  BuildProfile build_profile_;
+  GenerationProfiler* profiler_;
   /*
    * Templates
    */
-  tp::TemplateContainer t_cmakelists;
-  tp::TemplateContainer t_packagexml;
-  tp::TemplateContainer t_testlaunch_standalone;
-  tp::TemplateContainer t_testlaunch_separate;
-  tp::TemplateContainer t_umrf_graph;
-  tp::TemplateContainer t_macros_header;
-  tp::TemplateContainer t_bridge_header;
-  tp::TemplateContainer t_bridge_header_elif;
-
-  tp::TemplateContainer t_class_base;
-  tp::TemplateContainer t_execute_action;
-  tp::TemplateContainer t_get_input_params;
-  tp::TemplateContainer t_set_output_params;
-  tp::TemplateContainer t_parameter_in;
-  tp::TemplateContainer t_parameter_out;
-  tp::TemplateContainer t_parameter_decl;
-  tp::TemplateContainer t_comment;
-  tp::TemplateContainer t_line_comment;
+  CompiledTemplate t_cmakelists;
+  CompiledTemplate t_packagexml;
+  CompiledTemplate t_testlaunch_separate;
+  CompiledTemplate t_bench;
+  CompiledTemplate t_load_test;
+  CompiledTemplate t_load_test_launch;
+  CompiledTemplate t_bridge_header;
+  CompiledTemplate t_class_base;
+  CompiledTemplate t_class_async;
+  CompiledTemplate t_class_tick;
+  CompiledTemplate t_class_batch;
+  CompiledTemplate t_codec_header;
+  CompiledTemplate t_codec;
 };
 } // temoto_action_assistant namespace
 #endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT__TEMPLATE_ENGINE_H
+#define TEMOTO_ACTION_ASSISTANT__TEMPLATE_ENGINE_H
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief Structured arguments of a template: named string values and named lists, where
+ * each list item is a TemplateArguments object itself.
+ */
+class TemplateArguments
+{
+public:
+  typedef std::vector<TemplateArguments> List;
+
+  void set(const std::string& name, const std::string& value);
+
+  /**
+   * @brief Sets a value that is evaluated as a condition by "$(if name)"
+   */
+  void setFlag(const std::string& name, bool value);
+
+  /**
+   * @brief Appends a new item to the list "list_name" and returns a reference to it. The
+   * reference is invalidated by the next call to addListItem on the same list.
+   */
+  TemplateArguments& addListItem(const std::string& list_name);
+
+  /**
+   * @brief Creates the list "list_name" if it does not exist yet. A loop over a list that is
+   * not set is an error, hence lists that can be empty have to be declared.
+   */
+  void declareList(const std::string& list_name);
+
+  const std::string* findValue(const std::string& name) const;
+
+  const List* findList(const std::string& name) const;
+
+private:
+  std::map<std::string, std::string> values_;
+  std::map<std::string, List> lists_;
+};
+
+/**
+ * @brief A template that is parsed once and can then be rendered in a single pass.
+ *
+ * Supported directives:
+ *   $(arg name)                 value of "name", or of a field of a loop variable ("p.name")
+ *   $(for p in list) ... $(endfor)
+ *   $(if name) ... $(else) ... $(endif)
+ *   $(if !name) ... $(endif)
+ *
+ * Inside a loop, "loop.index", "loop.first" and "loop.last" are available. A condition is
+ * true if the value is a non-empty string or the list is non-empty. Control directives
+ * that stand alone on a line consume the whole line. Any other "$(...)" sequence and
+ * "$(arg name)" with an unknown top-level "name" are kept verbatim, so that roslaunch
+ * substitutions in the templates pass through. Rendering throws std::runtime_error if a
+ * loop refers to a list that is not set or "$(arg p.name)" to an unknown field.
+ */
+class CompiledTemplate
+{
+public:
+  CompiledTemplate();
+
+  /**
+   * @brief Compiles the template text. Throws std::runtime_error on syntax errors.
+   * @param template_text Text of the template
+   * @param defaults Values that are used for arguments which are not set during rendering
+   */
+  explicit CompiledTemplate(const std::string& template_text
+  , const std::map<std::string, std::string>& defaults = std::map<std::string, std::string>()
+  , const std::string& extension = "");
+
+  /**
+   * @brief Loads a file template ("<f_template>" XML with "<arg>" defaults and a CDATA body)
+   */
+  static CompiledTemplate fromFile(const std::string& file_path);
+
+  /**
+   * @brief Parses the content of a file template
+   */
+  static CompiledTemplate fromFileTemplateStr(const std::string& file_template_str, const std::string& source_name = "");
+
+  /**
+   * @brief Returns the exact size of the rendered output. This walks the whole template like
+   * render does, so render directly if the output is needed anyway.
+   */
+  std::size_t measure(const TemplateArguments& args) const;
+
+  /**
+   * @brief Renders the template into a string in a single pass
+   */
+  std::string render(const TemplateArguments& args) const;
+
+  void render(const TemplateArguments& args, std::ostream& out) const;
+
+  /**
+   * @brief File extension declared by the file template, e.g. ".txt"
+   */
+  const std::string& getExtension() const;
+
+  /**
+   * @brief Name of the source the template was loaded from, e.g. the template file name
+   */
+  const std::string& getName() const;
+
+  bool empty() const;
+
+  struct Node;
+
+private:
+  std::shared_ptr<const std::vector<Node>> nodes_;
+  std::map<std::string, std::string> defaults_;
+  std::string extension_;
+  std::string name_;
+};
+
+} // temoto_action_assistant namespace
+#endif
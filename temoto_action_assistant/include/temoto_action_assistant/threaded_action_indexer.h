@@ -17,12 +17,25 @@
 #ifndef TEMOTO_ACTION_ENGINE__THREADED_ACTION_INDEXER_H
 #define TEMOTO_ACTION_ENGINE__THREADED_ACTION_INDEXER_H
 
+#include "temoto_action_assistant/action_manifest.h"
 #include "temoto_action_engine/action_indexer.h"
+#include <memory>
+#include <set>
 #include <thread>
 #include <mutex>
 
 namespace temoto_action_assistant
 {
+/**
+ * @brief Periodically indexes the actions in the background. If the actions directory has an
+ * action manifest, the UMRFs are read from the manifest, which is mapped into memory and only
+ * decoded again when it has been replaced. Otherwise the directory tree is searched for UMRFs.
+ * 
+ * The manifest lists only the generated packages. Entries whose package directory was removed
+ * are dropped. If a listed UMRF file differs from the manifest, e.g. because it was edited by
+ * hand, or if the actions directory contains packages that are not listed, e.g. copied or
+ * hand-written ones, the tree is searched as well and its UMRFs are used for those packages.
+ */
 class ThreadedActionIndexer
 {
 public:
@@ -39,14 +52,56 @@ public:
   ~ThreadedActionIndexer();
 
 private:
+  struct ManifestUmrf
+  {
+    /// Directory of the package, relative to the actions directory
+    std::string package_directory;
+
+    /// Path and hash of the UMRF file as listed in the manifest
+    std::string umrf_path;
+    std::uint64_t umrf_hash = 0;
+    UmrfNode umrf;
+
+    /// Status of the UMRF file when it was last compared with the manifest
+    bool checked = false;
+    bool matches = false;
+    std::int64_t modification_time_ns = 0;
+    std::uint64_t size = 0;
+  };
+
+  std::string temoto_actions_path_;
   ActionIndexer action_indexer_;
   std::thread indexing_thread_;
   bool stop_indexing_ = false;
   std::vector<UmrfNode> umrfs_;
   mutable std::mutex umrfs_mutex_;
+  std::unique_ptr<MappedActionManifest> manifest_;
+  std::vector<ManifestUmrf> manifest_umrfs_;
+  bool manifest_valid_ = false;
 
   void startIndexing();
 
+  /**
+   * @brief Reads the UMRFs from the action manifest if it has changed. Drops the entries of the
+   * removed packages and merges the UMRFs of the packages that the manifest does not list or
+   * whose UMRF file differs from the manifest.
+   * @return false if there is no valid manifest and the actions have to be indexed otherwise
+   */
+  bool indexManifest();
+
+  /**
+   * @brief Whether the UMRF file of a listed package has the hash that the manifest lists. The
+   * file is read and hashed only if its size or modification time has changed since the last
+   * call, a missing file does not match.
+   */
+  bool umrfMatchesManifest(ManifestUmrf& manifest_umrf) const;
+
+  /**
+   * @brief Whether the actions directory contains a package with a UMRF that is not in the
+   * given package directories. Only the top level of the actions directory is checked.
+   */
+  bool hasUnlistedPackages(const std::set<std::string>& listed_directories) const;
+
   void stopIndexing();
 };
 } // temoto_action_assistant namespace
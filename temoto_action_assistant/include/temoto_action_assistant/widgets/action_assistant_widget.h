@@ -170,7 +170,9 @@ private:
   std::string temoto_actions_path_;
   std::string temoto_graphs_path_;
   std::string file_templates_path_;
+  std::string template_override_path_;
   std::string umrf_parameters_path_;
+  BuildProfile build_profile_;
 
   // ******************************************************************************************
   // Private Functions
@@ -0,0 +1,117 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TEMOTO_ACTION_ASSISTANT_CIRCLE_GRID_H
+#define TEMOTO_ACTION_ASSISTANT_CIRCLE_GRID_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+/**
+ * @brief Uniform grid over the circles of the UMRF graph. Each circle is stored in the cell of
+ * its centre, hence a query only visits the cells within the largest radius of the point, which
+ * keeps hit tests close to constant time regardless of the number of circles.
+ */
+class CircleGrid
+{
+public:
+  /**
+   * @param cell_size Side length of a cell in pixels, preferably at least the circle diameter
+   */
+  explicit CircleGrid(int cell_size);
+
+  /**
+   * @brief Adds the circle or moves it if a circle with the same name exists
+   */
+  void insert(const std::string& name, int x, int y, int radius);
+
+  void move(const std::string& name, int x, int y);
+
+  void remove(const std::string& name);
+
+  void clear();
+
+  /**
+   * @brief Returns the circle that contains the point or an empty string. If several circles
+   * contain the point, the one with the smallest name is returned.
+   */
+  std::string findCircleAt(int x, int y) const;
+
+  /**
+   * @brief Returns the circles with the centre inside the rectangle, e.g. for rubber band
+   * selection. The order is unspecified.
+   */
+  std::vector<std::string> findCirclesInRect(int left, int top, int right, int bottom) const;
+
+  /**
+   * @brief Appends the circles with the centre within the given distance of the point
+   */
+  void findCirclesNear(int x, int y, int distance, std::vector<std::string>& names) const;
+
+  /**
+   * @brief Gets the position of the circle, returns false if the circle does not exist
+   */
+  bool getPosition(const std::string& name, int& x, int& y) const;
+
+  /**
+   * @brief Pushes overlapping circles apart, starting from the seed circles and spreading only
+   * to the circles that get pushed. Each pass visits the circles that moved in the previous
+   * pass, so the work depends on the size of the affected neighbourhood, not on the graph.
+   * @param seed_names Circles where the relaxation starts, e.g. the circle that was dropped
+   * @param pin_seeds If true, the seed circles keep their position and only the others move
+   * @param spacing Gap between two circles after they were pushed apart
+   * @param max_passes Upper bound of relaxation passes
+   * @param moved_names Names of the circles that were moved, each name is appended once
+   * @return False if overlaps may remain after max_passes
+   */
+  bool resolveOverlaps(const std::vector<std::string>& seed_names
+  , bool pin_seeds
+  , int spacing
+  , int max_passes
+  , std::vector<std::string>& moved_names);
+
+  std::size_t size() const;
+
+private:
+  struct Circle
+  {
+    int x;
+    int y;
+    int radius;
+  };
+
+  int toCell(int coordinate) const;
+
+  static std::int64_t toCellKey(int cell_x, int cell_y);
+
+  void addToCell(const std::string& name, int x, int y);
+
+  void removeFromCell(const std::string& name, int x, int y);
+
+  int cell_size_;
+
+  /// Largest radius that was ever inserted, bounds the cells that a hit test has to visit
+  int max_radius_;
+  std::unordered_map<std::string, Circle> circles_;
+  std::unordered_map<std::int64_t, std::vector<std::string>> cells_;
+};
+
+} // temoto_action_assistant namespace
+#endif
@@ -40,6 +40,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QProgressBar>
+#include <QCheckBox>
 
 #ifndef Q_MOC_RUN
 #include <ros/ros.h>
@@ -74,7 +75,8 @@ public:
   , std::vector<std::shared_ptr<UmrfNode>>& umrfs
   , std::string temoto_actions_path
   , std::string temoto_graphs_path
-  , std::string file_template_path
+  , std::string template_override_path
+  , BuildProfile build_profile
   , std::shared_ptr<ThreadedActionIndexer> action_indexer);
 
   // ******************************************************************************************
@@ -84,10 +86,12 @@ public:
   QPushButton* btn_actions_dir_;
   QPushButton* btn_graphs_dir_;
   QPushButton* btn_generate_package_;
+  QPushButton* btn_dry_run_;
   QLabel* next_label_;
   QProgressBar* progress_bar_;
   QLineEdit* actions_path_field_;
   QLineEdit* graphs_path_field_;
+  QCheckBox* bundle_checkbox_;
 
   /// Contains the data related to the action
   std::vector<std::shared_ptr<UmrfNode>>& umrfs_;
@@ -98,6 +102,7 @@ private Q_SLOTS:
   // Slot Event Functions
   // ******************************************************************************************
   void generatePackages();
+  void dryRunRegeneration();
   void setActionsPath();
   void setGraphsPath();
 
@@ -109,6 +114,7 @@ private:
   std::string temoto_graphs_path_;
   std::string& umrf_graph_name_;
   ActionPackageGenerator apg_;
+  GenerationProfiler profiler_;
   std::shared_ptr<ThreadedActionIndexer> action_indexer_;
 
   // ******************************************************************************************
@@ -118,6 +124,11 @@ private:
   std::string convertToClassName(const std::string& name) const;
   void generateUmrfGraph() const;
 
+  /**
+   * \brief Shows the result of the generation along with the timing report of the profiler
+   */
+  void showGenerationReport(const std::string& message);
+
 };
 
 } // temoto action assistant namespace
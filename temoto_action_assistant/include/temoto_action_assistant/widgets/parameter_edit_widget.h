@@ -75,6 +75,12 @@ private Q_SLOTS:
 
   void addTypeDialog();
 
+  /// Adds a type that is passed as a shared immutable buffer, i.e., without copying
+  void addSharedTypeDialog();
+
+  /// Adds a type that holds the name of a ROS topic, which the action subscribes to
+  void addTopicTypeDialog();
+
 Q_SIGNALS:
 
   // ******************************************************************************************
@@ -96,6 +102,7 @@ private:
   // Private Functions
   // ******************************************************************************************
   void refreshTreeItemText(const ActionParameters::ParameterContainer* const parameter);
+  void addType(const std::string& parameter_type);
 
 };
 }
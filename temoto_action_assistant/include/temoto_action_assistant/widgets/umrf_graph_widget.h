@@ -21,12 +21,18 @@
 #include <QPainter>
 #include <QMouseEvent>
 #include <QPoint>
+#include <QPixmap>
+#include <QFont>
+#include <QLine>
+#include <QPolygon>
+#include <QRegion>
 
 #ifndef Q_MOC_RUN
 #endif
 
 #include "temoto_action_engine/umrf_node.h"
 #include "temoto_action_assistant/threaded_action_indexer.h"
+#include "temoto_action_assistant/widgets/circle_grid.h"
 #include <memory>
 #include <map>
 
@@ -78,6 +84,16 @@ public:
   std::vector<ConnectionHelper> connections_;
 };
 
+/**
+ * @brief Connection line and arrow head, cached until either end of the connection moves
+ */
+struct EdgeGeometry
+{
+  QLine line_;
+  QPolygon arrow_head_;
+  QRect bounds_;
+};
+
 class UmrfGraphWidget : public QWidget
 {
 Q_OBJECT
@@ -134,10 +150,22 @@ private:
   void mousePressEvent(QMouseEvent* event);
   void mouseMoveEvent(QMouseEvent *event);
   void mouseReleaseEvent(QMouseEvent *event);
-  void drawGraph();
+  void renderStaticLayer();
+  void drawEdge(QPainter& painter, const EdgeGeometry& edge) const;
+  void drawCircleShadow(QPainter& painter, const CircleHelper& circle) const;
+  void drawCircle(QPainter& painter, const CircleHelper& circle) const;
+  const EdgeGeometry& getEdgeGeometry(const CircleHelper& circle, const CircleHelper& other_circle);
+  QRect getCircleBounds(const CircleHelper& circle) const;
+  QRegion getDraggedRegion();
+  void startDrag(const std::string& circle_name);
+  void stopDrag();
+  void redrawGraph();
   bool isInBounds(int width, int height, int x_in, int y_in);
   void setNewSelectedCircle(const std::string& new_selected_circle_);
   std::string getUniqueCircleName();
+  void insertCircle(const CircleHelper& circle);
+  void moveCircle(const std::string& circle_name, int x, int y);
+  void resolveOverlaps(const std::vector<std::string>& seed_circles, bool pin_seeds);
   std::vector<std::shared_ptr<UmrfNode>> getDuplicateUmrfs(const std::string& umrf_name);
 
   int canvas_width_, canvas_height_;
@@ -146,6 +174,21 @@ private:
   std::string selected_circle_;
   bool circle_dropped_;
   std::map<std::string, CircleHelper> circles_;
+
+  /// Spatial index of circles_, has to be updated whenever a circle is added, moved or removed
+  CircleGrid circle_grid_;
+
+  /*
+   * Everything but the dragged circle and its connections is rendered into the static layer,
+   * so that dragging only repaints the regions that the dragged items cover
+   */
+  QPixmap static_layer_;
+  bool static_layer_dirty_;
+  std::string dragged_circle_;
+  std::vector<std::pair<std::string, std::string>> dragged_edges_;
+  std::map<std::pair<std::string, std::string>, EdgeGeometry> edge_geometries_;
+  QFont label_font_;
+  QFont description_font_;
   int circle_uniqueness_counter_;
 
   std::vector<std::shared_ptr<UmrfNode>>& umrfs_;
@@ -33,6 +33,7 @@
  *********************************************************************/
 
 #include "temoto_action_assistant/widgets/action_assistant_widget.h"
+#include "temoto_action_assistant/ta_package_generator.h"
 #include <ros/ros.h>
 #include <QApplication>
 #include <QMessageBox>
@@ -60,11 +61,13 @@ int main(int argc, char** argv)
   po::options_description desc("Allowed options");
   desc.add_options()
     ("help,h", "Show help message")("debug,g", "Run in debug/test mode")
-    ("ft_path", po::value<std::string>(), "Path to package generator templates")
+    ("ft_path", po::value<std::string>(), "Path to the action assistant resources")
+    ("to_path", po::value<std::string>(), "Directory with file templates that override the embedded package templates")
     ("ta_path", po::value<std::string>(), "Base path to where action package is generated to")
     ("ug_path", po::value<std::string>(), "Base path to where umrf graphs are generated")
     ("du_path", po::value<std::string>(), "Path to default UMRF that will be presented in the assistant")
-    ("up_path", po::value<std::string>(), "Path to default UMRF parameter definitions");
+    ("up_path", po::value<std::string>(), "Path to default UMRF parameter definitions")
+    ("build_profile", po::value<std::string>()->default_value("default"), "Build profile of the generated action packages: 'default' or 'fast'");
 
   // Process options
   po::variables_map vm;
@@ -77,6 +80,9 @@ int main(int argc, char** argv)
     {
       usage(desc, 0);
     }
+
+    // Validated here, the widget expects a known build profile
+    temoto_action_assistant::toBuildProfile(vm["build_profile"].as<std::string>());
   }
   catch (const std::exception& e)
   {
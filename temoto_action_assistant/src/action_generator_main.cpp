@@ -0,0 +1,173 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/package_regenerator.h"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace temoto_action_assistant;
+
+void usage(boost::program_options::options_description& desc, int exit_code)
+{
+  std::cout << desc << std::endl;
+  exit(exit_code);
+}
+
+void reportProfile(const boost::program_options::variables_map& vm, const GenerationProfiler& profiler)
+{
+  if (vm.count("profile"))
+  {
+    std::cout << profiler.formatReport();
+  }
+  if (vm.count("trace") && !profiler.writeChromeTrace(vm["trace"].as<std::string>()))
+  {
+    std::cerr << "Could not write the generation trace to '" << vm["trace"].as<std::string>() << "'" << std::endl;
+  }
+}
+
+/*
+ * Command line tool for regenerating the existing action packages, e.g. after the file
+ * templates have been updated. By default it only shows what would change, the packages
+ * are written with --write or into an archive with --tar.
+ */
+int main(int argc, char** argv)
+{
+  // Parse parameters
+  namespace po = boost::program_options;
+
+  // Declare the supported options
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "Show help message")
+    ("to_path", po::value<std::string>()->default_value(""), "Directory with file templates that override the embedded package templates")
+    ("ta_path", po::value<std::string>(), "Path to the directory that contains the action packages")
+    ("build_profile", po::value<std::string>()->default_value("default"), "Build profile of the generated action packages: 'default' or 'fast'")
+    ("dry_run", "Render the packages in memory and show how they differ from the packages on disk, nothing is written (default)")
+    ("write", "Regenerate the packages in the actions directory. Edited action sources, CMakeLists.txt and package.xml files are kept, their regenerated versions are written next to them as '<file>.new'")
+    ("name_only", "Show only the paths of the files that would change in a dry run")
+    ("threads", po::value<unsigned int>()->default_value(0), "Number of dry run threads, 0 uses all hardware threads")
+    ("tar", po::value<std::string>(), "Write the regenerated packages into a tar archive instead of the actions directory")
+    ("profile", "Show how long each generation stage, template and package took")
+    ("trace", po::value<std::string>(), "Save the generation timeline as a Chrome trace JSON file (chrome://tracing)");
+
+  // Process options
+  po::variables_map vm;
+  BuildProfile build_profile;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+      usage(desc, 0);
+    }
+
+    if (!vm.count("ta_path"))
+    {
+      throw std::runtime_error("--ta_path is required");
+    }
+
+    if ((vm.count("write") != 0) + (vm.count("tar") != 0) + (vm.count("dry_run") != 0) > 1)
+    {
+      throw std::runtime_error("--dry_run, --write and --tar are mutually exclusive");
+    }
+
+    build_profile = toBuildProfile(vm["build_profile"].as<std::string>());
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    usage(desc, 1);
+  }
+
+  const std::string temoto_actions_path = vm["ta_path"].as<std::string>();
+  ActionPackageGenerator apg(vm["to_path"].as<std::string>(), build_profile);
+  if (!apg.fileTemplatesLoaded())
+  {
+    std::cerr << "Could not load the file templates: " << apg.getTemplateLoadError() << std::endl;
+    return 1;
+  }
+
+  PackageRegenerator regenerator(apg, temoto_actions_path);
+
+  GenerationProfiler profiler;
+  if (vm.count("profile") || vm.count("trace"))
+  {
+    apg.setProfiler(&profiler);
+  }
+
+  /*
+   * Dry run: only report the differences
+   */
+  if (!vm.count("write") && !vm.count("tar"))
+  {
+    const DryRunReport report = regenerator.dryRun(vm["threads"].as<unsigned int>());
+    std::cout << PackageRegenerator::formatReport(report, !vm.count("name_only"));
+    reportProfile(vm, profiler);
+    return report.errors.empty() ? 0 : 1;
+  }
+
+  /*
+   * Regenerate the packages into a tar archive or in place
+   */
+  try
+  {
+    if (vm.count("tar"))
+    {
+      std::ofstream archive(vm["tar"].as<std::string>(), std::ios::out | std::ios::trunc | std::ios::binary);
+      if (!archive.is_open())
+      {
+        throw std::runtime_error("Could not open '" + vm["tar"].as<std::string>() + "' for writing");
+      }
+      TarSink sink(archive);
+      for (const auto& warning : regenerator.regenerate(sink))
+      {
+        std::cout << warning << std::endl;
+      }
+      sink.finish();
+    }
+    else
+    {
+      const WriteReport report = regenerator.writeInPlace();
+      for (const auto& warning : report.warnings)
+      {
+        std::cout << warning << std::endl;
+      }
+      regenerator.writeManifest();
+
+      std::cout << "Updated " << report.written_count << " files" << std::endl;
+      if (!report.new_files.empty())
+      {
+        std::cout << "Kept " << report.new_files.size() << " edited files, merge their regenerated versions:" << std::endl;
+        for (const auto& new_file : report.new_files)
+        {
+          std::cout << "  " << new_file << std::endl;
+        }
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "Regenerated " << regenerator.getJobs().size() << " packages" << std::endl;
+  reportProfile(vm, profiler);
+  return 0;
+}
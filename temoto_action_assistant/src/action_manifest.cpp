@@ -0,0 +1,496 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/action_manifest.h"
+#include "temoto_action_engine/umrf_json_converter.h"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace temoto_action_assistant
+{
+const std::string ACTION_MANIFEST_FILE_NAME = "action_manifest.bin";
+
+namespace
+{
+const char MANIFEST_TAG[4] = {'T', 'A', 'M', 'F'};
+const std::uint32_t MANIFEST_VERSION = 1;
+
+class ManifestWriter
+{
+public:
+  explicit ManifestWriter(std::string& buffer)
+  : buffer_(buffer)
+  {}
+
+  void writeInteger(std::uint64_t value, std::size_t bytes)
+  {
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+      buffer_.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  void writeString(const std::string& value)
+  {
+    if (value.size() > UINT32_MAX)
+    {
+      throw std::length_error("A string is too large for the action manifest");
+    }
+    writeInteger(value.size(), 4);
+    buffer_.append(value);
+  }
+
+private:
+  std::string& buffer_;
+};
+
+class ManifestReader
+{
+public:
+  ManifestReader(const char* data, std::size_t size)
+  : data_(data)
+  , size_(size)
+  , position_(0)
+  {}
+
+  std::uint64_t readInteger(std::size_t bytes)
+  {
+    require(bytes);
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(data_ + position_);
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+      value |= std::uint64_t(data[i]) << (8 * i);
+    }
+    position_ += bytes;
+    return value;
+  }
+
+  std::string readString()
+  {
+    const std::size_t length = readInteger(4);
+    require(length);
+    std::string value(data_ + position_, length);
+    position_ += length;
+    return value;
+  }
+
+  void readTag()
+  {
+    require(sizeof(MANIFEST_TAG));
+    if (std::memcmp(data_, MANIFEST_TAG, sizeof(MANIFEST_TAG)) != 0)
+    {
+      throw std::runtime_error("The file is not an action manifest");
+    }
+    position_ += sizeof(MANIFEST_TAG);
+  }
+
+  bool atEnd() const
+  {
+    return position_ == size_;
+  }
+
+private:
+  void require(std::size_t bytes) const
+  {
+    if (size_ - position_ < bytes)
+    {
+      throw std::runtime_error("The action manifest is truncated");
+    }
+  }
+
+  const char* data_;
+  std::size_t size_;
+  std::size_t position_;
+};
+
+std::string getManifestPath(const std::string& actions_path)
+{
+  return actions_path + "/" + ACTION_MANIFEST_FILE_NAME;
+}
+
+std::string getErrorString(const std::string& message, const std::string& path)
+{
+  return message + " '" + path + "': " + std::strerror(errno);
+}
+
+/*
+ * Writes the manifest next to the final location and renames it over the old manifest, which
+ * is atomic within a file system
+ */
+void replaceManifest(const std::string& actions_path, const std::vector<ActionManifestEntry>& entries)
+{
+  const std::string manifest_path = getManifestPath(actions_path);
+  const std::string temporary_path = manifest_path + ".tmp." + std::to_string(::getpid());
+  const std::string content = encodeActionManifest(entries);
+
+  int fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error(getErrorString("Could not create", temporary_path));
+  }
+
+  std::size_t written = 0;
+  while (written < content.size())
+  {
+    const ssize_t result = ::write(fd, content.data() + written, content.size() - written);
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result < 0)
+    {
+      const std::string error = getErrorString("Could not write", temporary_path);
+      ::close(fd);
+      ::unlink(temporary_path.c_str());
+      throw std::runtime_error(error);
+    }
+    written += result;
+  }
+
+  // The content has to reach the disk before the rename, otherwise a crash can leave an empty manifest
+  if (::fsync(fd) != 0 || ::close(fd) != 0)
+  {
+    const std::string error = getErrorString("Could not write", temporary_path);
+    ::unlink(temporary_path.c_str());
+    throw std::runtime_error(error);
+  }
+
+  if (::rename(temporary_path.c_str(), manifest_path.c_str()) != 0)
+  {
+    const std::string error = getErrorString("Could not replace", manifest_path);
+    ::unlink(temporary_path.c_str());
+    throw std::runtime_error(error);
+  }
+}
+
+/*
+ * Holds an exclusive lock on the lock file of the manifest for its lifetime
+ */
+class ManifestLock
+{
+public:
+  explicit ManifestLock(const std::string& actions_path)
+  : lock_path_(getManifestPath(actions_path) + ".lock")
+  , fd_(::open(lock_path_.c_str(), O_RDWR | O_CREAT, 0644))
+  {
+    if (fd_ < 0)
+    {
+      throw std::runtime_error(getErrorString("Could not open", lock_path_));
+    }
+    while (::flock(fd_, LOCK_EX) != 0)
+    {
+      if (errno != EINTR)
+      {
+        const std::string error = getErrorString("Could not lock", lock_path_);
+        ::close(fd_);
+        throw std::runtime_error(error);
+      }
+    }
+  }
+
+  ~ManifestLock()
+  {
+    ::flock(fd_, LOCK_UN);
+    ::close(fd_);
+  }
+
+  ManifestLock(const ManifestLock&) = delete;
+  ManifestLock& operator=(const ManifestLock&) = delete;
+
+private:
+  std::string lock_path_;
+  int fd_;
+};
+} // anonymous namespace
+
+std::uint64_t hashUmrfJson(const std::string& umrf_json)
+{
+  // 64-bit FNV-1a
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : umrf_json)
+  {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::vector<ActionManifestEntry> makeActionManifestEntries(const std::vector<UmrfNode>& umrfs
+, const std::string& package_name
+, bool bundle)
+{
+  std::vector<ActionManifestEntry> entries;
+  std::set<std::string> class_names;
+
+  for (const auto& umrf : umrfs)
+  {
+    if (bundle && !class_names.insert(umrf.getName()).second)
+    {
+      continue;
+    }
+
+    ActionManifestEntry entry;
+    entry.package_name = umrf.getPackageName();
+    entry.class_name = umrf.getName();
+    entry.library_path = "lib/lib" + package_name + ".so";
+    entry.umrf_path = bundle
+      ? package_name + "/umrf/" + entry.package_name + ".umrf.json"
+      : package_name + "/umrf.json";
+    entry.umrf_json = umrf_json_converter::toUmrfJsonStr(umrf, true);
+    entry.umrf_hash = hashUmrfJson(entry.umrf_json);
+
+    for (const auto& input_param : umrf.getInputParameters())
+    {
+      entry.parameters.push_back(ActionManifestParameter{input_param.getName(), input_param.getType(), true});
+    }
+    for (const auto& output_param : umrf.getOutputParameters())
+    {
+      entry.parameters.push_back(ActionManifestParameter{output_param.getName(), output_param.getType(), false});
+    }
+    entries.push_back(entry);
+
+    if (!bundle)
+    {
+      break;
+    }
+  }
+  return entries;
+}
+
+std::string encodeActionManifest(const std::vector<ActionManifestEntry>& entries)
+{
+  std::string buffer;
+  ManifestWriter writer(buffer);
+  buffer.append(MANIFEST_TAG, sizeof(MANIFEST_TAG));
+  writer.writeInteger(MANIFEST_VERSION, 4);
+  writer.writeInteger(entries.size(), 4);
+
+  for (const auto& entry : entries)
+  {
+    writer.writeString(entry.package_name);
+    writer.writeString(entry.class_name);
+    writer.writeString(entry.library_path);
+    writer.writeString(entry.umrf_path);
+    writer.writeInteger(entry.umrf_hash, 8);
+    writer.writeInteger(entry.parameters.size(), 4);
+    for (const auto& parameter : entry.parameters)
+    {
+      writer.writeInteger(parameter.input ? 1 : 0, 1);
+      writer.writeString(parameter.name);
+      writer.writeString(parameter.type);
+    }
+    writer.writeString(entry.umrf_json);
+  }
+  return buffer;
+}
+
+std::vector<ActionManifestEntry> decodeActionManifest(const char* data, std::size_t size)
+{
+  ManifestReader reader(data, size);
+  reader.readTag();
+  if (reader.readInteger(4) != MANIFEST_VERSION)
+  {
+    throw std::runtime_error("The action manifest has an unsupported format version");
+  }
+
+  const std::size_t entry_count = reader.readInteger(4);
+  std::vector<ActionManifestEntry> entries;
+  for (std::size_t i = 0; i < entry_count; i++)
+  {
+    ActionManifestEntry entry;
+    entry.package_name = reader.readString();
+    entry.class_name = reader.readString();
+    entry.library_path = reader.readString();
+    entry.umrf_path = reader.readString();
+    entry.umrf_hash = reader.readInteger(8);
+
+    const std::size_t parameter_count = reader.readInteger(4);
+    for (std::size_t j = 0; j < parameter_count; j++)
+    {
+      ActionManifestParameter parameter;
+      parameter.input = reader.readInteger(1) != 0;
+      parameter.name = reader.readString();
+      parameter.type = reader.readString();
+      entry.parameters.push_back(parameter);
+    }
+    entry.umrf_json = reader.readString();
+    entries.push_back(entry);
+  }
+
+  if (!reader.atEnd())
+  {
+    throw std::runtime_error("The action manifest has trailing data");
+  }
+  return entries;
+}
+
+void writeActionManifest(const std::string& actions_path, const std::vector<ActionManifestEntry>& entries)
+{
+  boost::filesystem::create_directories(actions_path);
+  ManifestLock lock(actions_path);
+  replaceManifest(actions_path, entries);
+}
+
+void updateActionManifest(const std::string& actions_path, const std::vector<ActionManifestEntry>& entries)
+{
+  boost::filesystem::create_directories(actions_path);
+  ManifestLock lock(actions_path);
+
+  std::vector<ActionManifestEntry> merged_entries;
+  MappedActionManifest manifest(actions_path);
+  manifest.refresh();
+  if (manifest.exists())
+  {
+    try
+    {
+      merged_entries = manifest.getEntries();
+    }
+    catch (const std::exception& e)
+    {
+      std::cout << "Discarding the action manifest in '" << actions_path << "': " << e.what() << std::endl;
+    }
+  }
+
+  // Drop the entries that are replaced by the new ones
+  auto is_replaced = [&](const ActionManifestEntry& old_entry)
+  {
+    for (const auto& entry : entries)
+    {
+      if (entry.library_path == old_entry.library_path)
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+  merged_entries.erase(std::remove_if(merged_entries.begin(), merged_entries.end(), is_replaced)
+  , merged_entries.end());
+  merged_entries.insert(merged_entries.end(), entries.begin(), entries.end());
+
+  replaceManifest(actions_path, merged_entries);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * MappedActionManifest
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+MappedActionManifest::MappedActionManifest(const std::string& actions_path)
+: manifest_path_(getManifestPath(actions_path))
+, data_(nullptr)
+, size_(0)
+, inode_(0)
+, modification_time_ns_(0)
+, exists_(false)
+{}
+
+MappedActionManifest::~MappedActionManifest()
+{
+  unmap();
+}
+
+bool MappedActionManifest::refresh()
+{
+  struct stat status;
+  if (::stat(manifest_path_.c_str(), &status) != 0)
+  {
+    const bool changed = exists_;
+    unmap();
+    exists_ = false;
+    return changed;
+  }
+
+  // The manifest is only ever replaced by a rename, which gives it a new inode
+  const std::int64_t modification_time_ns = std::int64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+  if (exists_
+  && inode_ == status.st_ino
+  && size_ == std::size_t(status.st_size)
+  && modification_time_ns_ == modification_time_ns)
+  {
+    return false;
+  }
+
+  unmap();
+  int fd = ::open(manifest_path_.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    exists_ = false;
+    return true;
+  }
+
+  // Stat the opened file, the manifest could have been replaced after the first stat
+  if (::fstat(fd, &status) != 0)
+  {
+    ::close(fd);
+    exists_ = false;
+    return true;
+  }
+
+  if (status.st_size > 0)
+  {
+    void* data = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      ::close(fd);
+      throw std::runtime_error(getErrorString("Could not map", manifest_path_));
+    }
+    data_ = static_cast<const char*>(data);
+  }
+  ::close(fd);
+
+  size_ = status.st_size;
+  inode_ = status.st_ino;
+  modification_time_ns_ = std::int64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+  exists_ = true;
+  return true;
+}
+
+bool MappedActionManifest::exists() const
+{
+  return exists_;
+}
+
+std::vector<ActionManifestEntry> MappedActionManifest::getEntries() const
+{
+  if (!exists_)
+  {
+    return std::vector<ActionManifestEntry>();
+  }
+  return decodeActionManifest(data_, size_);
+}
+
+void MappedActionManifest::unmap()
+{
+  if (data_ != nullptr)
+  {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+} // temoto_action_assistant namespace
@@ -0,0 +1,217 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/widgets/circle_grid.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+using namespace temoto_action_assistant;
+
+namespace
+{
+const int RADIUS = 25;
+const int SPACING = 10;
+const int MAX_PASSES = 64;
+
+struct Position
+{
+  int x;
+  int y;
+};
+
+/*
+ * Synthetic graph layout: the circles are placed row by row, the way the graph editor stacks
+ * the added actions, with a random jitter that keeps them apart
+ */
+std::vector<Position> makeLayout(int node_count, std::mt19937& rng)
+{
+  const int columns = std::max(1, int(std::sqrt(node_count)));
+  const int step = 2 * RADIUS + SPACING + 20;
+  std::uniform_int_distribution<int> jitter(-10, 10);
+
+  std::vector<Position> positions;
+  positions.reserve(node_count);
+  for (int i = 0; i < node_count; i++)
+  {
+    positions.push_back(Position{(i % columns) * step + jitter(rng), (i / columns) * step + jitter(rng)});
+  }
+  return positions;
+}
+
+std::string nodeName(int index)
+{
+  return "action_" + std::to_string(index);
+}
+
+int countOverlaps(const CircleGrid& grid, int node_count)
+{
+  int overlaps = 0;
+  std::vector<std::string> neighbour_names;
+  for (int i = 0; i < node_count; i++)
+  {
+    int x, y;
+    grid.getPosition(nodeName(i), x, y);
+    neighbour_names.clear();
+    grid.findCirclesNear(x, y, 2 * RADIUS - 1, neighbour_names);
+    overlaps += neighbour_names.size() - 1;
+  }
+  return overlaps / 2;
+}
+
+/*
+ * The previous overlap handling of the graph editor: one sweep over all pairs
+ */
+void pushApartAllPairs(std::vector<Position>& positions)
+{
+  for (std::size_t i = 0; i < positions.size(); i++)
+  {
+    for (std::size_t j = 0; j < positions.size(); j++)
+    {
+      if (i == j)
+      {
+        continue;
+      }
+      const int x_diff = positions[i].x - positions[j].x;
+      const int y_diff = positions[i].y - positions[j].y;
+      const int overlap = 2 * RADIUS - int(std::sqrt(std::pow(x_diff, 2) + std::pow(y_diff, 2)));
+      if (overlap <= 0)
+      {
+        continue;
+      }
+      const float direction = std::atan2(y_diff, x_diff);
+      positions[j].x -= (overlap + SPACING) * std::cos(direction);
+      positions[j].y -= (overlap + SPACING) * std::sin(direction);
+    }
+  }
+}
+
+double toMicroseconds(std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void benchmarkDrops(int node_count, int drop_count, std::mt19937& rng)
+{
+  std::vector<Position> positions = makeLayout(node_count, rng);
+  CircleGrid grid(64);
+  for (int i = 0; i < node_count; i++)
+  {
+    grid.insert(nodeName(i), positions[i].x, positions[i].y, RADIUS);
+  }
+
+  int max_x = 0;
+  int max_y = 0;
+  for (const auto& position : positions)
+  {
+    max_x = std::max(max_x, position.x);
+    max_y = std::max(max_y, position.y);
+  }
+  std::uniform_int_distribution<int> node(0, node_count - 1);
+  std::uniform_int_distribution<int> x_drop(0, max_x);
+  std::uniform_int_distribution<int> y_drop(0, max_y);
+
+  std::vector<double> durations;
+  std::size_t moved_total = 0;
+  int unresolved = 0;
+  std::vector<std::string> moved_names;
+  for (int i = 0; i < drop_count; i++)
+  {
+    // Drop a circle on a random spot, which mostly lands on top of other circles
+    const std::string name = nodeName(node(rng));
+    grid.move(name, x_drop(rng), y_drop(rng));
+
+    moved_names.clear();
+    const auto start = std::chrono::steady_clock::now();
+    if (!grid.resolveOverlaps({name}, true, SPACING, MAX_PASSES, moved_names))
+    {
+      unresolved++;
+    }
+    durations.push_back(toMicroseconds(std::chrono::steady_clock::now() - start));
+    moved_total += moved_names.size();
+  }
+
+  std::sort(durations.begin(), durations.end());
+  double sum = 0;
+  for (double duration : durations)
+  {
+    sum += duration;
+  }
+
+  // Reference: a single sweep of the previous all pairs check
+  const auto start = std::chrono::steady_clock::now();
+  pushApartAllPairs(positions);
+  const double all_pairs_duration = toMicroseconds(std::chrono::steady_clock::now() - start);
+
+  printf("%8d %10.1f %10.1f %10.1f %8.1f %8d %10d %14.1f\n"
+  , node_count
+  , sum / durations.size()
+  , durations[durations.size() / 2]
+  , durations.back()
+  , double(moved_total) / drop_count
+  , unresolved
+  , countOverlaps(grid, node_count)
+  , all_pairs_duration);
+}
+}
+
+/*
+ * Measures how long resolving the overlaps takes when a circle is dropped in the UMRF graph
+ * editor, on synthetic graphs of 1k to 10k circles
+ */
+int main(int argc, char** argv)
+{
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "Show help message")
+    ("drops", po::value<int>()->default_value(1000), "Number of dropped circles per graph")
+    ("seed", po::value<unsigned int>()->default_value(1), "Seed of the synthetic graphs");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return 1;
+  }
+
+  if (vm.count("help") || vm["drops"].as<int>() <= 0)
+  {
+    std::cout << desc << std::endl;
+    return vm.count("help") ? 0 : 1;
+  }
+
+  std::mt19937 rng(vm["seed"].as<unsigned int>());
+
+  printf("%8s %10s %10s %10s %8s %8s %10s %14s\n"
+  , "nodes", "mean [us]", "p50 [us]", "max [us]", "moved", "capped", "overlaps", "all pairs [us]");
+  for (int node_count : {1000, 2000, 5000, 10000})
+  {
+    benchmarkDrops(node_count, vm["drops"].as<int>(), rng);
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/embedded_templates.h"
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <stdexcept>
+
+namespace temoto_action_assistant
+{
+const EmbeddedTemplate* EmbeddedTemplateTable::find(const std::string& name) const
+{
+  for (std::size_t i = 0; i < count; i++)
+  {
+    if (name == templates[i].name)
+    {
+      return &templates[i];
+    }
+  }
+  return nullptr;
+}
+
+TemplateLoader::TemplateLoader(const EmbeddedTemplateTable& embedded_templates, const std::string& override_path)
+: embedded_templates_(embedded_templates)
+, override_path_(override_path)
+{
+  if (!override_path_.empty() && !boost::filesystem::is_directory(override_path_))
+  {
+    std::cout << "File template override directory '" << override_path_
+      << "' does not exist, using the embedded templates" << std::endl;
+    override_path_.clear();
+  }
+}
+
+CompiledTemplate TemplateLoader::load(const std::string& name) const
+{
+  if (!override_path_.empty())
+  {
+    const std::string override_file = override_path_ + "/" + name;
+    if (boost::filesystem::exists(override_file))
+    {
+      std::cout << "Using file template override '" << override_file << "'" << std::endl;
+      return CompiledTemplate::fromFile(override_file);
+    }
+  }
+
+  const EmbeddedTemplate* embedded_template = embedded_templates_.find(name);
+  if (embedded_template == nullptr)
+  {
+    throw std::runtime_error("File template '" + name + "' is not embedded and not found in the override directory");
+  }
+  return CompiledTemplate::fromFileTemplateStr(std::string(embedded_template->content, embedded_template->size), name);
+}
+
+} // temoto_action_assistant namespace
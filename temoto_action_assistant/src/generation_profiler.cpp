@@ -0,0 +1,307 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/generation_profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace temoto_action_assistant
+{
+namespace
+{
+// Package that is currently being generated by this thread
+thread_local const std::string* current_package = nullptr;
+
+double toMs(GenerationProfiler::Clock::duration duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double toUs(GenerationProfiler::Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+std::string escapeJson(const std::string& str)
+{
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str)
+  {
+    switch (c)
+    {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char code[7];
+          std::snprintf(code, sizeof(code), "\\u%04x", c);
+          escaped += code;
+        }
+        else
+        {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+struct Aggregate
+{
+  std::string name;
+  std::size_t count = 0;
+  GenerationProfiler::Clock::duration total = GenerationProfiler::Clock::duration::zero();
+  GenerationProfiler::Clock::duration max = GenerationProfiler::Clock::duration::zero();
+};
+
+/*
+ * Sums up the events per key, the result is sorted by the total duration
+ */
+template <typename KeyFunction>
+std::vector<Aggregate> aggregate(const std::vector<GenerationProfiler::Event>& events, KeyFunction get_key)
+{
+  std::map<std::string, Aggregate> aggregates;
+  for (const auto& event : events)
+  {
+    std::string key;
+    if (!get_key(event, key))
+    {
+      continue;
+    }
+    Aggregate& entry = aggregates[key];
+    entry.name = key;
+    entry.count++;
+    entry.total += event.duration;
+    entry.max = std::max(entry.max, event.duration);
+  }
+
+  std::vector<Aggregate> sorted;
+  for (const auto& entry : aggregates)
+  {
+    sorted.push_back(entry.second);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const Aggregate& a, const Aggregate& b)
+  {
+    return a.total > b.total;
+  });
+  return sorted;
+}
+
+void appendTable(std::stringstream& ss, const std::string& title, const std::vector<Aggregate>& rows, std::size_t max_rows)
+{
+  char line[256];
+  ss << "\n" << title << "\n";
+  std::snprintf(line, sizeof(line), "  %-40s %10s %8s %10s %10s\n", "", "total ms", "count", "mean ms", "max ms");
+  ss << line;
+  for (std::size_t i = 0; i < rows.size() && i < max_rows; i++)
+  {
+    const Aggregate& row = rows[i];
+    std::snprintf(line, sizeof(line), "  %-40s %10.3f %8zu %10.3f %10.3f\n"
+    , row.name.c_str()
+    , toMs(row.total)
+    , row.count
+    , toMs(row.total) / row.count
+    , toMs(row.max));
+    ss << line;
+  }
+}
+} // anonymous namespace
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * ScopedTimer
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+GenerationProfiler::ScopedTimer::ScopedTimer(GenerationProfiler* profiler, const char* stage, const std::string& detail)
+: profiler_(profiler)
+, stage_(stage)
+{
+  if (profiler_ != nullptr)
+  {
+    detail_ = detail;
+    start_ = Clock::now();
+  }
+}
+
+GenerationProfiler::ScopedTimer::~ScopedTimer()
+{
+  stop();
+}
+
+void GenerationProfiler::ScopedTimer::stop()
+{
+  if (profiler_ != nullptr)
+  {
+    profiler_->record(stage_, detail_, start_, Clock::now());
+    profiler_ = nullptr;
+  }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * PackageScope
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+GenerationProfiler::PackageScope::PackageScope(GenerationProfiler* profiler, const std::string& package_name)
+: previous_package_(current_package)
+, package_name_(package_name)
+, timer_(profiler, "package")
+{
+  current_package = &package_name_;
+}
+
+GenerationProfiler::PackageScope::~PackageScope()
+{
+  // The package stage itself is attributed to the package as well
+  timer_.stop();
+  current_package = previous_package_;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * GenerationProfiler
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+GenerationProfiler::GenerationProfiler()
+: created_(Clock::now())
+{}
+
+void GenerationProfiler::clear()
+{
+  std::lock_guard<std::mutex> events_lock(events_mutex_);
+  events_.clear();
+  created_ = Clock::now();
+}
+
+std::vector<GenerationProfiler::Event> GenerationProfiler::getEvents() const
+{
+  std::lock_guard<std::mutex> events_lock(events_mutex_);
+  return events_;
+}
+
+void GenerationProfiler::record(const char* stage, const std::string& detail, Clock::time_point start, Clock::time_point end)
+{
+  Event event;
+  event.stage = stage;
+  event.package = (current_package != nullptr) ? *current_package : "";
+  event.detail = detail;
+  event.start = start;
+  event.duration = end - start;
+
+  std::lock_guard<std::mutex> events_lock(events_mutex_);
+  event.thread_index = getThreadIndex();
+  events_.push_back(std::move(event));
+}
+
+unsigned int GenerationProfiler::getThreadIndex()
+{
+  const std::thread::id thread_id = std::this_thread::get_id();
+  for (const auto& thread_index : thread_indices_)
+  {
+    if (thread_index.first == thread_id)
+    {
+      return thread_index.second;
+    }
+  }
+  thread_indices_.emplace_back(thread_id, thread_indices_.size());
+  return thread_indices_.back().second;
+}
+
+std::string GenerationProfiler::formatReport(std::size_t max_rows) const
+{
+  const std::vector<Event> events = getEvents();
+  if (events.empty())
+  {
+    return "No generation stages were recorded\n";
+  }
+
+  // Wall time from the first start to the last end
+  Clock::time_point first_start = events.front().start;
+  Clock::time_point last_end = events.front().start + events.front().duration;
+  for (const auto& event : events)
+  {
+    first_start = std::min(first_start, event.start);
+    last_end = std::max(last_end, event.start + event.duration);
+  }
+
+  const auto stages = aggregate(events, [](const Event& event, std::string& key)
+  {
+    key = event.stage;
+    return true;
+  });
+
+  const auto templates = aggregate(events, [](const Event& event, std::string& key)
+  {
+    key = event.detail;
+    return event.stage == std::string("render");
+  });
+
+  const auto packages = aggregate(events, [](const Event& event, std::string& key)
+  {
+    key = event.package;
+    return event.stage == std::string("package");
+  });
+
+  std::stringstream ss;
+  ss << "Generation profile: " << packages.size() << " packages, " << events.size()
+    << " timed stages, " << toMs(last_end - first_start) << " ms wall time\n";
+  appendTable(ss, "Stages:", stages, stages.size());
+  appendTable(ss, "Slowest templates:", templates, max_rows);
+  appendTable(ss, "Slowest packages:", packages, max_rows);
+  return ss.str();
+}
+
+std::string GenerationProfiler::toChromeTrace() const
+{
+  const std::vector<Event> events = getEvents();
+
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << "{\"traceEvents\":[";
+  for (std::size_t i = 0; i < events.size(); i++)
+  {
+    const Event& event = events[i];
+    ss << (i == 0 ? "\n" : ",\n")
+      << "{\"name\":\"" << escapeJson(event.detail.empty() ? event.stage : event.stage + " " + event.detail) << "\""
+      << ",\"cat\":\"" << escapeJson(event.stage) << "\""
+      << ",\"ph\":\"X\""
+      << ",\"ts\":" << toUs(event.start - created_)
+      << ",\"dur\":" << toUs(event.duration)
+      << ",\"pid\":1"
+      << ",\"tid\":" << event.thread_index
+      << ",\"args\":{\"package\":\"" << escapeJson(event.package) << "\"}}";
+  }
+  ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return ss.str();
+}
+
+bool GenerationProfiler::writeChromeTrace(const std::string& file_path) const
+{
+  std::ofstream trace_file(file_path);
+  if (!trace_file.is_open())
+  {
+    return false;
+  }
+  trace_file << toChromeTrace();
+  return trace_file.good();
+}
+
+} // temoto_action_assistant namespace
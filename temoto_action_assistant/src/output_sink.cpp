@@ -0,0 +1,375 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/output_sink.h"
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace temoto_action_assistant
+{
+namespace
+{
+const std::size_t TAR_BLOCK_SIZE = 512;
+
+/*
+ * Removes empty and "." segments from a "/" separated path
+ */
+std::string normalizePath(const std::string& path)
+{
+  std::string normalized_path;
+  std::size_t segment_begin = 0;
+  while (segment_begin <= path.size())
+  {
+    std::size_t segment_end = path.find('/', segment_begin);
+    if (segment_end == std::string::npos)
+    {
+      segment_end = path.size();
+    }
+
+    const std::string segment = path.substr(segment_begin, segment_end - segment_begin);
+    if (!segment.empty() && segment != ".")
+    {
+      if (!normalized_path.empty())
+      {
+        normalized_path += "/";
+      }
+      normalized_path += segment;
+    }
+    segment_begin = segment_end + 1;
+  }
+  return normalized_path;
+}
+
+/*
+ * Returns the path and all of its parent directories, starting from the topmost one
+ */
+std::vector<std::string> getDirectoryChain(const std::string& path)
+{
+  std::vector<std::string> chain;
+  std::size_t separator_pos = path.find('/');
+  while (separator_pos != std::string::npos)
+  {
+    chain.push_back(path.substr(0, separator_pos));
+    separator_pos = path.find('/', separator_pos + 1);
+  }
+  if (!path.empty())
+  {
+    chain.push_back(path);
+  }
+  return chain;
+}
+
+void writeOctal(char* field, std::size_t field_size, unsigned long long value)
+{
+  // The field is zero padded and terminated with a null character
+  std::snprintf(field, field_size, "%0*llo", static_cast<int>(field_size - 1), value);
+}
+} // anonymous namespace
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * OutputSink
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+const std::size_t OutputSink::UNKNOWN_SIZE = static_cast<std::size_t>(-1);
+
+void OutputSink::writeFile(const std::string& path, const std::string& content)
+{
+  beginFile(path, content.size()).write(content.data(), content.size());
+  endFile();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * FileSystemSink
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+FileSystemSink::FileSystemSink(const std::string& base_path)
+: base_path_(base_path)
+{}
+
+void FileSystemSink::createDirectory(const std::string& path)
+{
+  boost::filesystem::create_directories(base_path_ + "/" + path);
+}
+
+std::ostream& FileSystemSink::beginFile(const std::string& path, std::size_t /*size*/)
+{
+  file_.open(base_path_ + "/" + path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file_.is_open())
+  {
+    std::cout << "Could not open file '" << base_path_ << "/" << path << "' for writing" << std::endl;
+  }
+  return file_;
+}
+
+void FileSystemSink::endFile()
+{
+  file_.close();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * MemorySink
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+MemorySink::MemorySink()
+: stream_(&buffer_)
+{}
+
+void MemorySink::createDirectory(const std::string& path)
+{
+  for (const auto& directory : getDirectoryChain(normalizePath(path)))
+  {
+    directories_.insert(directory);
+  }
+}
+
+std::ostream& MemorySink::beginFile(const std::string& path, std::size_t size)
+{
+  std::string& content = files_[normalizePath(path)];
+  content.clear();
+  if (size != UNKNOWN_SIZE)
+  {
+    content.reserve(size);
+  }
+  buffer_.target = &content;
+  stream_.clear();
+  return stream_;
+}
+
+void MemorySink::endFile()
+{
+  buffer_.target = nullptr;
+}
+
+const std::map<std::string, std::string>& MemorySink::getFiles() const
+{
+  return files_;
+}
+
+const std::set<std::string>& MemorySink::getDirectories() const
+{
+  return directories_;
+}
+
+const std::string* MemorySink::findFile(const std::string& path) const
+{
+  const auto file_it = files_.find(normalizePath(path));
+  if (file_it == files_.end())
+  {
+    return nullptr;
+  }
+  return &file_it->second;
+}
+
+MemorySink::StringAppendBuf::int_type MemorySink::StringAppendBuf::overflow(int_type ch)
+{
+  if (target == nullptr)
+  {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    target->push_back(traits_type::to_char_type(ch));
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize MemorySink::StringAppendBuf::xsputn(const char* s, std::streamsize n)
+{
+  if (target == nullptr)
+  {
+    return 0;
+  }
+  target->append(s, n);
+  return n;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * TarSink
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+TarSink::TarSink(std::ostream& archive)
+: archive_(archive)
+, stream_(&buffer_)
+, file_size_(0)
+, finished_(false)
+, buffering_(false)
+{
+  buffer_.target = archive_.rdbuf();
+}
+
+TarSink::~TarSink()
+{
+  try
+  {
+    finish();
+  }
+  catch (...)
+  {
+    // Destructors must not throw
+  }
+}
+
+void TarSink::createDirectory(const std::string& path)
+{
+  for (const auto& directory : getDirectoryChain(normalizePath(path)))
+  {
+    if (written_directories_.insert(directory).second)
+    {
+      writeHeader(directory + "/", 0, '5');
+    }
+  }
+}
+
+std::ostream& TarSink::beginFile(const std::string& path, std::size_t size)
+{
+  if (size == UNKNOWN_SIZE)
+  {
+    buffering_ = true;
+    buffered_path_ = normalizePath(path);
+    buffered_content_.str(std::string());
+    buffered_content_.clear();
+    return buffered_content_;
+  }
+
+  writeHeader(normalizePath(path), size, '0');
+  file_size_ = size;
+  buffer_.count = 0;
+  stream_.clear();
+  return stream_;
+}
+
+void TarSink::endFile()
+{
+  if (buffering_)
+  {
+    buffering_ = false;
+    const std::string content = buffered_content_.str();
+    writeHeader(buffered_path_, content.size(), '0');
+    archive_.write(content.data(), content.size());
+    writePadding(content.size());
+    return;
+  }
+
+  if (buffer_.count != file_size_)
+  {
+    throw std::runtime_error("Tar entry size mismatch: declared " + std::to_string(file_size_)
+      + " bytes but " + std::to_string(buffer_.count) + " bytes were written");
+  }
+  writePadding(file_size_);
+}
+
+void TarSink::finish()
+{
+  if (finished_)
+  {
+    return;
+  }
+
+  // The end of the archive is marked by two zero filled blocks
+  const char zeros[2 * TAR_BLOCK_SIZE] = {};
+  archive_.write(zeros, sizeof(zeros));
+  archive_.flush();
+  finished_ = true;
+}
+
+void TarSink::writeHeader(const std::string& path, std::size_t size, char type_flag)
+{
+  if (finished_)
+  {
+    throw std::runtime_error("Cannot add '" + path + "' to a finished tar archive");
+  }
+
+  char header[TAR_BLOCK_SIZE] = {};
+
+  // Paths longer than 100 characters are split into the "prefix" and "name" fields
+  std::string name = path;
+  std::string prefix;
+  if (name.size() > 100)
+  {
+    std::size_t split_pos = path.find('/');
+    while (split_pos != std::string::npos && path.size() - split_pos - 1 > 100)
+    {
+      split_pos = path.find('/', split_pos + 1);
+    }
+    if (split_pos == std::string::npos || split_pos == 0 || split_pos > 155)
+    {
+      throw std::runtime_error("Path '" + path + "' is too long for a tar archive");
+    }
+    prefix = path.substr(0, split_pos);
+    name = path.substr(split_pos + 1);
+  }
+
+  std::memcpy(header, name.data(), name.size());
+  writeOctal(header + 100, 8, type_flag == '5' ? 0755 : 0644);
+  writeOctal(header + 108, 8, 0);
+  writeOctal(header + 116, 8, 0);
+  writeOctal(header + 124, 12, size);
+  writeOctal(header + 136, 12, static_cast<unsigned long long>(std::time(nullptr)));
+  header[156] = type_flag;
+  std::memcpy(header + 257, "ustar", 6);
+  std::memcpy(header + 263, "00", 2);
+  std::memcpy(header + 345, prefix.data(), prefix.size());
+
+  // The checksum is computed with the checksum field filled with spaces
+  std::memset(header + 148, ' ', 8);
+  unsigned int checksum = 0;
+  for (const char byte : header)
+  {
+    checksum += static_cast<unsigned char>(byte);
+  }
+  std::snprintf(header + 148, 8, "%06o", checksum);
+
+  archive_.write(header, TAR_BLOCK_SIZE);
+  if (!archive_)
+  {
+    throw std::runtime_error("Could not write to the tar archive");
+  }
+}
+
+void TarSink::writePadding(std::size_t size)
+{
+  // File content is padded to the block size
+  const std::size_t padding = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+  const char zeros[TAR_BLOCK_SIZE] = {};
+  archive_.write(zeros, padding);
+}
+
+TarSink::CountingBuf::int_type TarSink::CountingBuf::overflow(int_type ch)
+{
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    if (traits_type::eq_int_type(target->sputc(traits_type::to_char_type(ch)), traits_type::eof()))
+    {
+      return traits_type::eof();
+    }
+    ++count;
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize TarSink::CountingBuf::xsputn(const char* s, std::streamsize n)
+{
+  const std::streamsize written = target->sputn(s, n);
+  count += written;
+  return written;
+}
+
+} // temoto_action_assistant namespace
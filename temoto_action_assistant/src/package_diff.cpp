@@ -0,0 +1,307 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/package_diff.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace temoto_action_assistant
+{
+namespace
+{
+enum class EditType
+{
+  EQUAL,
+  DELETE,
+  INSERT
+};
+
+/*
+ * A single line of the edit script. The positions refer to the line before which the
+ * edit applies in the original and the changed file.
+ */
+struct Edit
+{
+  EditType type;
+  std::size_t old_pos;
+  std::size_t new_pos;
+};
+
+/*
+ * Splits the content into lines, each line keeps its terminating newline
+ */
+std::vector<std::string> splitLines(const std::string& content)
+{
+  std::vector<std::string> lines;
+  std::size_t line_begin = 0;
+  while (line_begin < content.size())
+  {
+    std::size_t line_end = content.find('\n', line_begin);
+    line_end = (line_end == std::string::npos) ? content.size() : line_end + 1;
+    lines.push_back(content.substr(line_begin, line_end - line_begin));
+    line_begin = line_end;
+  }
+  return lines;
+}
+
+/*
+ * Computes the shortest edit script with the Myers O(ND) algorithm. The common prefix and
+ * suffix are stripped first, which keeps the search small for typical template changes.
+ */
+std::vector<Edit> diffLines(const std::vector<std::string>& a, const std::vector<std::string>& b)
+{
+  std::size_t prefix = 0;
+  while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix])
+  {
+    prefix++;
+  }
+
+  std::size_t suffix = 0;
+  while (suffix < a.size() - prefix && suffix < b.size() - prefix
+    && a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix])
+  {
+    suffix++;
+  }
+
+  const int n = static_cast<int>(a.size() - prefix - suffix);
+  const int m = static_cast<int>(b.size() - prefix - suffix);
+  const int max_d = n + m;
+  const int offset = max_d + 1;
+
+  /*
+   * Forward pass, the state of the furthest reaching paths is stored for every edit
+   * distance d so that the script can be recovered afterwards
+   */
+  std::vector<int> v(2 * max_d + 3, 0);
+  std::vector<std::vector<int>> trace;
+  for (int d = 0; d <= max_d; d++)
+  {
+    trace.push_back(v);
+    bool done = false;
+    for (int k = -d; k <= d; k += 2)
+    {
+      int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+        ? v[offset + k + 1]
+        : v[offset + k - 1] + 1;
+      int y = x - k;
+      while (x < n && y < m && a[prefix + x] == b[prefix + y])
+      {
+        x++;
+        y++;
+      }
+      v[offset + k] = x;
+      if (x >= n && y >= m)
+      {
+        done = true;
+        break;
+      }
+    }
+    if (done)
+    {
+      break;
+    }
+  }
+
+  /*
+   * Backtrack from the end of both sequences
+   */
+  std::vector<Edit> edits;
+  for (std::size_t i = 0; i < suffix; i++)
+  {
+    edits.push_back(Edit{EditType::EQUAL, a.size() - 1 - i, b.size() - 1 - i});
+  }
+
+  int x = n;
+  int y = m;
+  for (int d = static_cast<int>(trace.size()) - 1; d >= 0; d--)
+  {
+    const std::vector<int>& v_d = trace[d];
+    const int k = x - y;
+    const int prev_k = (k == -d || (k != d && v_d[offset + k - 1] < v_d[offset + k + 1])) ? k + 1 : k - 1;
+    const int prev_x = v_d[offset + prev_k];
+    const int prev_y = prev_x - prev_k;
+
+    while (x > prev_x && y > prev_y)
+    {
+      edits.push_back(Edit{EditType::EQUAL, prefix + x - 1, prefix + y - 1});
+      x--;
+      y--;
+    }
+
+    if (d > 0)
+    {
+      if (x == prev_x)
+      {
+        edits.push_back(Edit{EditType::INSERT, prefix + x, prefix + y - 1});
+      }
+      else
+      {
+        edits.push_back(Edit{EditType::DELETE, prefix + x - 1, prefix + y});
+      }
+    }
+    x = prev_x;
+    y = prev_y;
+  }
+
+  for (std::size_t i = prefix; i > 0; i--)
+  {
+    edits.push_back(Edit{EditType::EQUAL, i - 1, i - 1});
+  }
+
+  std::reverse(edits.begin(), edits.end());
+  return edits;
+}
+
+void appendLine(std::string& out, char marker, const std::string& line)
+{
+  out += marker;
+  out += line;
+  if (line.empty() || line.back() != '\n')
+  {
+    out += "\n\\ No newline at end of file\n";
+  }
+}
+
+/*
+ * Unified diff ranges are 1-based, an empty range refers to the line before it
+ */
+std::string formatRange(std::size_t start, std::size_t count)
+{
+  return std::to_string(count == 0 ? start : start + 1) + "," + std::to_string(count);
+}
+
+bool readFile(const std::string& file_path, std::string& content)
+{
+  std::ifstream file(file_path, std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+} // anonymous namespace
+
+std::string makeUnifiedDiff(const std::string& old_content
+, const std::string& new_content
+, const std::string& old_label
+, const std::string& new_label
+, unsigned int context_lines)
+{
+  if (old_content == new_content)
+  {
+    return "";
+  }
+
+  const std::vector<std::string> old_lines = splitLines(old_content);
+  const std::vector<std::string> new_lines = splitLines(new_content);
+  const std::vector<Edit> edits = diffLines(old_lines, new_lines);
+
+  std::string out = "--- " + old_label + "\n+++ " + new_label + "\n";
+
+  std::size_t i = 0;
+  while (i < edits.size())
+  {
+    // Find the beginning of the next change
+    while (i < edits.size() && edits[i].type == EditType::EQUAL)
+    {
+      i++;
+    }
+    if (i == edits.size())
+    {
+      break;
+    }
+
+    /*
+     * Changes that are separated by less than two contexts worth of unchanged lines are
+     * merged into one hunk
+     */
+    const std::size_t hunk_begin = (i > context_lines) ? i - context_lines : 0;
+    std::size_t last_change = i;
+    std::size_t j = i;
+    while (j < edits.size())
+    {
+      if (edits[j].type != EditType::EQUAL)
+      {
+        last_change = j;
+      }
+      else if (j - last_change > 2 * context_lines)
+      {
+        break;
+      }
+      j++;
+    }
+    const std::size_t hunk_end = std::min(edits.size(), last_change + context_lines + 1);
+
+    std::size_t old_count = 0;
+    std::size_t new_count = 0;
+    std::string hunk_body;
+    for (std::size_t e = hunk_begin; e < hunk_end; e++)
+    {
+      const Edit& edit = edits[e];
+      switch (edit.type)
+      {
+        case EditType::EQUAL:
+          appendLine(hunk_body, ' ', old_lines[edit.old_pos]);
+          old_count++;
+          new_count++;
+          break;
+        case EditType::DELETE:
+          appendLine(hunk_body, '-', old_lines[edit.old_pos]);
+          old_count++;
+          break;
+        case EditType::INSERT:
+          appendLine(hunk_body, '+', new_lines[edit.new_pos]);
+          new_count++;
+          break;
+      }
+    }
+
+    out += "@@ -" + formatRange(edits[hunk_begin].old_pos, old_count)
+      + " +" + formatRange(edits[hunk_begin].new_pos, new_count) + " @@\n";
+    out += hunk_body;
+    i = hunk_end;
+  }
+
+  return out;
+}
+
+std::vector<FileChange> diffAgainstDisk(const MemorySink& sink, const std::string& base_path)
+{
+  std::vector<FileChange> changes;
+  std::string disk_content;
+
+  for (const auto& file : sink.getFiles())
+  {
+    if (!readFile(base_path + "/" + file.first, disk_content))
+    {
+      changes.push_back(FileChange{FileChange::Type::ADDED
+      , file.first
+      , makeUnifiedDiff("", file.second, "/dev/null", "b/" + file.first)});
+    }
+    else if (disk_content != file.second)
+    {
+      changes.push_back(FileChange{FileChange::Type::MODIFIED
+      , file.first
+      , makeUnifiedDiff(disk_content, file.second, "a/" + file.first, "b/" + file.first)});
+    }
+  }
+
+  return changes;
+}
+
+} // temoto_action_assistant namespace
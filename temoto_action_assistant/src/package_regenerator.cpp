@@ -0,0 +1,344 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/package_regenerator.h"
+#include "temoto_action_assistant/action_manifest.h"
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include "rapidjson/document.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace temoto_action_assistant
+{
+namespace
+{
+std::string readFile(const std::string& file_path)
+{
+  std::ifstream file(file_path, std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Could not open '" + file_path + "'");
+  }
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/*
+ * Extracts the "umrf" entries of a bundle manifest in the order they are listed
+ */
+std::vector<std::string> getBundledUmrfPaths(const std::string& manifest)
+{
+  rapidjson::Document document;
+  document.Parse(manifest.c_str(), manifest.size());
+  if (document.HasParseError()
+  || !document.IsObject()
+  || !document.HasMember("actions")
+  || !document["actions"].IsArray())
+  {
+    throw std::runtime_error("Malformed bundle manifest");
+  }
+
+  std::vector<std::string> umrf_paths;
+  const rapidjson::Value& actions = document["actions"];
+  for (rapidjson::SizeType i = 0; i < actions.Size(); i++)
+  {
+    if (!actions[i].IsObject() || !actions[i].HasMember("umrf") || !actions[i]["umrf"].IsString())
+    {
+      throw std::runtime_error("Malformed bundle manifest");
+    }
+    umrf_paths.emplace_back(actions[i]["umrf"].GetString(), actions[i]["umrf"].GetStringLength());
+  }
+  return umrf_paths;
+}
+} // anonymous namespace
+
+PackageRegenerator::PackageRegenerator(const ActionPackageGenerator& apg, const std::string& actions_path)
+: apg_(apg)
+, actions_path_(actions_path)
+{
+  namespace fs = boost::filesystem;
+
+  if (!fs::is_directory(actions_path_))
+  {
+    index_errors_.push_back("'" + actions_path_ + "' is not a directory");
+    return;
+  }
+
+  for (fs::directory_iterator it(actions_path_); it != fs::directory_iterator(); ++it)
+  {
+    if (!fs::is_directory(it->path()))
+    {
+      continue;
+    }
+
+    const std::string package_path = it->path().string();
+    GenerationJob job;
+    job.package_name = it->path().filename().string();
+
+    try
+    {
+      if (fs::exists(package_path + "/bundle_manifest.json"))
+      {
+        job.bundle = true;
+        for (const auto& umrf_path : getBundledUmrfPaths(readFile(package_path + "/bundle_manifest.json")))
+        {
+          job.umrfs.push_back(umrf_json_converter::fromUmrfJsonStr(readFile(package_path + "/" + umrf_path), true));
+        }
+      }
+      else if (fs::exists(package_path + "/umrf.json"))
+      {
+        job.bundle = false;
+        job.umrfs.push_back(umrf_json_converter::fromUmrfJsonStr(readFile(package_path + "/umrf.json"), true));
+      }
+      else
+      {
+        continue;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      index_errors_.push_back(job.package_name + ": " + e.what());
+      continue;
+    }
+
+    jobs_.push_back(job);
+  }
+
+  std::sort(jobs_.begin(), jobs_.end(), [](const GenerationJob& a, const GenerationJob& b)
+  {
+    return a.package_name < b.package_name;
+  });
+}
+
+const std::vector<GenerationJob>& PackageRegenerator::getJobs() const
+{
+  return jobs_;
+}
+
+std::vector<std::string> PackageRegenerator::generate(const GenerationJob& job, OutputSink& sink) const
+{
+  std::vector<std::string> warnings;
+  if (job.bundle)
+  {
+    for (const auto& skipped_umrf : apg_.generateBundle(job.umrfs, job.package_name, sink))
+    {
+      warnings.push_back(job.package_name + ": skipped '" + skipped_umrf
+        + "' because the bundle already contains a class with the same name");
+    }
+  }
+  else
+  {
+    apg_.generatePackage(job.umrfs.front(), sink);
+  }
+  return warnings;
+}
+
+WriteReport PackageRegenerator::writeInPlace() const
+{
+  namespace fs = boost::filesystem;
+
+  WriteReport report;
+  report.warnings = index_errors_;
+  FileSystemSink disk_sink(actions_path_);
+
+  for (const auto& job : jobs_)
+  {
+    try
+    {
+      MemorySink sink;
+      const std::vector<std::string> job_warnings = generate(job, sink);
+      report.warnings.insert(report.warnings.end(), job_warnings.begin(), job_warnings.end());
+
+      for (const auto& directory : sink.getDirectories())
+      {
+        disk_sink.createDirectory(directory);
+      }
+
+      for (const auto& file : sink.getFiles())
+      {
+        const std::string disk_path = actions_path_ + "/" + file.first;
+        if (fs::exists(disk_path))
+        {
+          if (readFile(disk_path) == file.second)
+          {
+            continue;
+          }
+          if (isUserFile(file.first))
+          {
+            disk_sink.writeFile(file.first + ".new", file.second);
+            report.new_files.push_back(file.first + ".new");
+            continue;
+          }
+        }
+        disk_sink.writeFile(file.first, file.second);
+        report.written_count++;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      report.warnings.push_back(job.package_name + ": " + e.what());
+    }
+  }
+  return report;
+}
+
+bool PackageRegenerator::isUserFile(const std::string& path)
+{
+  const std::size_t package_end = path.find('/');
+  if (package_end == std::string::npos)
+  {
+    return false;
+  }
+
+  const std::string package_path = path.substr(package_end + 1);
+  return package_path == "CMakeLists.txt"
+    || package_path == "package.xml"
+    || (package_path.compare(0, 4, "src/") == 0
+      && package_path.find('/', 4) == std::string::npos
+      && boost::algorithm::ends_with(package_path, ".cpp"));
+}
+
+std::vector<std::string> PackageRegenerator::regenerate(OutputSink& sink) const
+{
+  std::vector<std::string> warnings;
+  for (const auto& job : jobs_)
+  {
+    const std::vector<std::string> job_warnings = generate(job, sink);
+    warnings.insert(warnings.end(), job_warnings.begin(), job_warnings.end());
+  }
+  return warnings;
+}
+
+void PackageRegenerator::writeManifest() const
+{
+  std::vector<ActionManifestEntry> entries;
+  for (const auto& job : jobs_)
+  {
+    const auto job_entries = makeActionManifestEntries(job.umrfs, job.package_name, job.bundle);
+    entries.insert(entries.end(), job_entries.begin(), job_entries.end());
+  }
+  writeActionManifest(actions_path_, entries);
+}
+
+DryRunReport PackageRegenerator::dryRun(unsigned int thread_count) const
+{
+  const auto start_time = std::chrono::steady_clock::now();
+
+  if (thread_count == 0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  thread_count = std::min<unsigned int>(thread_count, std::max<std::size_t>(1, jobs_.size()));
+
+  /*
+   * Every job renders into its own in-memory sink and is diffed against the disk right
+   * away, so the memory footprint is bounded by the number of workers
+   */
+  std::vector<std::vector<FileChange>> job_changes(jobs_.size());
+  std::vector<std::size_t> job_file_counts(jobs_.size(), 0);
+  std::vector<std::vector<std::string>> job_errors(jobs_.size());
+  std::atomic<std::size_t> next_job(0);
+
+  auto worker = [&]()
+  {
+    for (std::size_t i = next_job++; i < jobs_.size(); i = next_job++)
+    {
+      try
+      {
+        MemorySink sink;
+        job_errors[i] = generate(jobs_[i], sink);
+        job_file_counts[i] = sink.getFiles().size();
+        GenerationProfiler::ScopedTimer timer(apg_.getProfiler(), "diff", jobs_[i].package_name);
+        job_changes[i] = diffAgainstDisk(sink, actions_path_);
+      }
+      catch (const std::exception& e)
+      {
+        job_errors[i].push_back(jobs_[i].package_name + ": " + e.what());
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < thread_count; i++)
+  {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& worker_thread : workers)
+  {
+    worker_thread.join();
+  }
+
+  DryRunReport report;
+  report.package_count = jobs_.size();
+  report.errors = index_errors_;
+  for (std::size_t i = 0; i < jobs_.size(); i++)
+  {
+    report.file_count += job_file_counts[i];
+    std::move(job_changes[i].begin(), job_changes[i].end(), std::back_inserter(report.changes));
+    report.errors.insert(report.errors.end(), job_errors[i].begin(), job_errors[i].end());
+  }
+
+  report.duration_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+  return report;
+}
+
+std::string PackageRegenerator::formatReport(const DryRunReport& report, bool include_diffs)
+{
+  std::stringstream ss;
+  std::size_t added_count = 0;
+
+  for (const auto& change : report.changes)
+  {
+    if (change.type == FileChange::Type::ADDED)
+    {
+      added_count++;
+    }
+
+    if (include_diffs)
+    {
+      ss << change.diff;
+    }
+    else
+    {
+      ss << (change.type == FileChange::Type::ADDED ? "A " : "M ") << change.path;
+      if (change.type == FileChange::Type::MODIFIED && isUserFile(change.path))
+      {
+        ss << " (kept, --write saves it as " << change.path << ".new)";
+      }
+      ss << "\n";
+    }
+  }
+
+  for (const auto& error : report.errors)
+  {
+    ss << "Error: " << error << "\n";
+  }
+
+  ss << report.changes.size() << " of " << report.file_count << " files in " << report.package_count
+    << " packages would change (" << added_count << " added, " << report.changes.size() - added_count
+    << " modified), checked in " << static_cast<long>(report.duration_ms) << " ms\n";
+
+  return ss.str();
+}
+
+} // temoto_action_assistant namespace
@@ -0,0 +1,119 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/parameter_types.h"
+#include "temoto_action_engine/action_parameter.h"
+#include <boost/algorithm/string.hpp>
+#include <set>
+
+namespace temoto_action_assistant
+{
+const std::string SHARED_TYPE_PREFIX = "shared:";
+const std::string TOPIC_TYPE_PREFIX = "topic:";
+
+bool isSharedType(const std::string& parameter_type)
+{
+  return parameter_type.compare(0, SHARED_TYPE_PREFIX.size(), SHARED_TYPE_PREFIX) == 0;
+}
+
+std::string toSharedType(const std::string& cpp_type)
+{
+  return SHARED_TYPE_PREFIX + cpp_type;
+}
+
+std::string getSharedType(const std::string& shared_type)
+{
+  return shared_type.substr(SHARED_TYPE_PREFIX.size());
+}
+
+bool isTopicType(const std::string& parameter_type)
+{
+  return parameter_type.compare(0, TOPIC_TYPE_PREFIX.size(), TOPIC_TYPE_PREFIX) == 0;
+}
+
+std::string toTopicType(const std::string& message_type)
+{
+  return TOPIC_TYPE_PREFIX + message_type;
+}
+
+std::string getMessageType(const std::string& topic_type)
+{
+  return topic_type.substr(TOPIC_TYPE_PREFIX.size());
+}
+
+bool isMessageType(const std::string& cpp_type)
+{
+  const std::string MESSAGE_PACKAGE_SUFFIX = "_msgs";
+  const std::size_t separator = cpp_type.find("::");
+  if (separator == std::string::npos
+  || separator < MESSAGE_PACKAGE_SUFFIX.size()
+  || cpp_type.find("::", separator + 2) != std::string::npos
+  || cpp_type.find_first_of("<>, ") != std::string::npos)
+  {
+    return false;
+  }
+  return cpp_type.compare(separator - MESSAGE_PACKAGE_SUFFIX.size(), MESSAGE_PACKAGE_SUFFIX.size(), MESSAGE_PACKAGE_SUFFIX) == 0;
+}
+
+std::string getMessageHeader(const std::string& message_type)
+{
+  std::string message_header = message_type;
+  boost::replace_all(message_header, "::", "/");
+  return message_header + ".h";
+}
+
+std::string getMessagePackage(const std::string& message_type)
+{
+  return message_type.substr(0, message_type.find("::"));
+}
+
+bool hasBinaryEncoding(const std::string& parameter_type)
+{
+  static const std::set<std::string> ENCODED_CPP_TYPES = {
+    "bool"
+  , "double"
+  , "std::string"
+  , "std::vector<double>"
+  , "std::vector<std::string>"};
+
+  return ENCODED_CPP_TYPES.count(toCppType(parameter_type)) != 0;
+}
+
+std::string toCppType(const std::string& parameter_type)
+{
+  if (isSharedType(parameter_type))
+  {
+    return "std::shared_ptr<const " + toCppType(parameter_type.substr(SHARED_TYPE_PREFIX.size())) + ">";
+  }
+
+  // The parameter holds the name of the topic
+  if (isTopicType(parameter_type))
+  {
+    return "std::string";
+  }
+
+  const auto type_it = action_parameter::PARAMETER_MAP.find(parameter_type);
+  if (type_it != action_parameter::PARAMETER_MAP.end())
+  {
+    return type_it->second;
+  }
+  else
+  {
+    return parameter_type;
+  }
+}
+
+} // temoto_action_assistant namespace
@@ -15,58 +15,292 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "temoto_action_assistant/ta_package_generator.h"
-#include <boost/filesystem.hpp>
+#include "temoto_action_assistant/action_manifest.h"
+#include "temoto_action_assistant/embedded_templates.h"
+#include "temoto_action_assistant/parameter_types.h"
 #include <boost/algorithm/string.hpp>
-#include <fstream>
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <cstdint>
+#include <iostream>
 #include <set>
+#include <stdexcept>
+
+// Generated from "file_templates/" at build time
+extern const temoto_action_assistant::EmbeddedTemplateTable ACTION_ASSISTANT_TEMPLATES;
 
 namespace temoto_action_assistant
 {
-ActionPackageGenerator::ActionPackageGenerator(const std::string& file_template_path)
-: file_template_path_(file_template_path + "/")
-, file_templates_loaded_(false)
+namespace
+{
+/*
+ * Entry of "bundle_manifest.json"
+ */
+struct BundledAction
 {
-  if (file_template_path_.empty())
+  std::string package_name;
+  std::string class_name;
+  std::string umrf_path;
+};
+
+void writeJsonString(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, const std::string& value)
+{
+  writer.String(value.c_str(), static_cast<rapidjson::SizeType>(value.size()));
+}
+
+/*
+ * Serializes the manifest that maps each UMRF of a bundle to its class in the bundle library
+ */
+std::string toBundleManifestJson(const std::string& bundle_name, const std::vector<BundledAction>& actions)
+{
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.SetIndent(' ', 2);
+
+  writer.StartObject();
+  writer.Key("bundle");
+  writeJsonString(writer, bundle_name);
+  writer.Key("library");
+  writeJsonString(writer, "lib/lib" + bundle_name + ".so");
+  writer.Key("actions");
+  writer.StartArray();
+  for (const auto& action : actions)
   {
-    return;
+    writer.StartObject();
+    writer.Key("package_name");
+    writeJsonString(writer, action.package_name);
+    writer.Key("class_name");
+    writeJsonString(writer, action.class_name);
+    writer.Key("umrf");
+    writeJsonString(writer, action.umrf_path);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  return std::string(buffer.GetString(), buffer.GetSize()) + "\n";
+}
+
+/*
+ * Converts parameter names such as "pose::x" to C++ compliant member names
+ */
+std::string toMemberName(const std::string& prefix, const std::string& parameter_name)
+{
+  std::string member_name = prefix + parameter_name;
+  boost::replace_all(member_name, "::", "_");
+  return member_name;
+}
+
+/*
+ * Collects the C++ types of the input and output parameters of the UMRF
+ */
+void collectParameterTypes(const UmrfNode& umrf, std::map<std::string, std::string>& parameter_types)
+{
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    parameter_types[input_param.getType()] = toCppType(input_param.getType());
+  }
+  for (const auto& output_param : umrf.getOutputParameters())
+  {
+    parameter_types[output_param.getType()] = toCppType(output_param.getType());
+  }
+}
+
+/*
+ * Collects the ROS message types that the topic parameters and the shared buffer parameters
+ * refer to
+ */
+std::set<std::string> getMessageTypes(const std::map<std::string, std::string>& parameter_types)
+{
+  std::set<std::string> message_types;
+  for (const auto& parameter_type : parameter_types)
+  {
+    if (isTopicType(parameter_type.first))
+    {
+      message_types.insert(getMessageType(parameter_type.first));
+    }
+    else if (isSharedType(parameter_type.first) && isMessageType(getSharedType(parameter_type.first)))
+    {
+      message_types.insert(getSharedType(parameter_type.first));
+    }
+  }
+  return message_types;
+}
+
+std::set<std::string> getMessagePackages(const std::map<std::string, std::string>& parameter_types)
+{
+  std::set<std::string> message_packages;
+  for (const auto& message_type : getMessageTypes(parameter_types))
+  {
+    message_packages.insert(getMessagePackage(message_type));
+  }
+  return message_packages;
+}
+
+bool hasTopicParameters(const std::map<std::string, std::string>& parameter_types)
+{
+  for (const auto& parameter_type : parameter_types)
+  {
+    if (isTopicType(parameter_type.first))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool hasParameterCodec(const UmrfNode& umrf)
+{
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    if (!hasBinaryEncoding(input_param.getType()))
+    {
+      return false;
+    }
+  }
+  for (const auto& output_param : umrf.getOutputParameters())
+  {
+    if (!hasBinaryEncoding(output_param.getType()))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * FNV-1a hash of the parameter names and types, changes whenever the parameters change
+ */
+std::uint32_t getSchemaVersion(const UmrfNode& umrf)
+{
+  std::string schema;
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    schema += input_param.getName() + ":" + input_param.getType() + ";";
+  }
+  schema += "|";
+  for (const auto& output_param : umrf.getOutputParameters())
+  {
+    schema += output_param.getName() + ":" + output_param.getType() + ";";
   }
 
-  // Import the CMakeLists template
-  t_cmakelists = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_cmakelists.xml");
+  std::uint32_t hash = 2166136261u;
+  for (unsigned char c : schema)
+  {
+    hash = (hash ^ c) * 16777619u;
+  }
+  return hash;
+}
+
+bool hasInputParameter(const UmrfNode& umrf, const std::string& parameter_name)
+{
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    if (input_param.getName() == parameter_name)
+    {
+      return true;
+    }
+  }
+  return false;
+}
 
-  // Import the package.xml template
-  t_packagexml = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_packagexml.xml");
+/*
+ * Returns true if the UMRF has an input parameter with the given name and type
+ */
+bool hasInputParameter(const UmrfNode& umrf, const std::string& parameter_name, const std::string& parameter_type)
+{
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    if (input_param.getName() == parameter_name)
+    {
+      return input_param.getType() == parameter_type;
+    }
+  }
+  return false;
+}
+} // anonymous namespace
 
-  // Import the action test templates
-  //t_testlaunch_standalone = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_action_test_standalone.xml");
-  t_testlaunch_separate   = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_action_test_separate.xml");
-  t_umrf_graph            = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_umrf_graphtxt.xml");
-  
-  // Import the macros.h template
-  t_macros_header  = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_macros_header.xml");
+BuildProfile toBuildProfile(const std::string& build_profile_name)
+{
+  if (build_profile_name == "default")
+  {
+    return BuildProfile::DEFAULT;
+  }
+  else if (build_profile_name == "fast")
+  {
+    return BuildProfile::FAST_BUILD;
+  }
+  else
+  {
+    throw std::invalid_argument("Unknown build profile '" + build_profile_name + "', expected 'default' or 'fast'");
+  }
+}
 
-  // Import the temoto_action.h template
-  t_bridge_header  = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_bridge_header.xml");
-  t_bridge_header_elif = tp::TemplateContainer(file_template_path_ + "file_templates/temoto_ta_update_params_elif.xml");
+ActionPackageGenerator::ActionPackageGenerator(const std::string& template_override_path, BuildProfile build_profile)
+: file_templates_loaded_(false)
+, build_profile_(build_profile)
+, profiler_(nullptr)
+{
+  // Templates in the override directory take precedence over the embedded ones
+  TemplateLoader loader(ACTION_ASSISTANT_TEMPLATES, template_override_path);
 
-  // Import the action implementation c++ code templates
-  t_class_base        = tp::TemplateContainer(file_template_path_ + "file_templates/ta_class_base.xml");
-  t_execute_action    = tp::TemplateContainer(file_template_path_ + "file_templates/ta_execute_action.xml");
-  t_get_input_params  = tp::TemplateContainer(file_template_path_ + "file_templates/ta_get_input_params.xml");
-  t_set_output_params = tp::TemplateContainer(file_template_path_ + "file_templates/ta_set_output_params.xml");
-  t_parameter_in      = tp::TemplateContainer(file_template_path_ + "file_templates/ta_parameter_in.xml");
-  t_parameter_out     = tp::TemplateContainer(file_template_path_ + "file_templates/ta_parameter_out.xml");
-  t_parameter_decl    = tp::TemplateContainer(file_template_path_ + "file_templates/ta_parameter_decl.xml");
-  t_line_comment      = tp::TemplateContainer(file_template_path_ + "file_templates/ta_line_comment.xml");
+  try
+  {
+    // Import the CMakeLists and package.xml templates
+    t_cmakelists = loader.load("temoto_ta_cmakelists.xml");
+    t_packagexml = loader.load("temoto_ta_packagexml.xml");
+
+    // Import the action test, microbenchmark and load test templates
+    t_testlaunch_separate = loader.load("temoto_ta_action_test_separate.xml");
+    t_bench = loader.load("temoto_ta_bench.xml");
+    t_load_test = loader.load("temoto_ta_load_test.xml");
+    t_load_test_launch = loader.load("temoto_ta_load_test_launch.xml");
+
+    // Import the temoto_action.h template
+    t_bridge_header = loader.load("temoto_ta_bridge_header.xml");
+
+    // Import the action implementation c++ code templates
+    t_class_base = loader.load("ta_class_base.xml");
+    t_class_async = loader.load("ta_class_async.xml");
+    t_class_tick = loader.load("ta_class_tick.xml");
+    t_class_batch = loader.load("ta_class_batch.xml");
+
+    // Import the binary parameter codec templates
+    t_codec_header = loader.load("temoto_ta_codec_header.xml");
+    t_codec = loader.load("ta_codec.xml");
+  }
+  catch (const std::exception& e)
+  {
+    template_load_error_ = e.what();
+    return;
+  }
 
   file_templates_loaded_ = true;
 }
 
-void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, const std::string& package_path)
+bool ActionPackageGenerator::fileTemplatesLoaded() const
+{
+  return file_templates_loaded_;
+}
+
+const std::string& ActionPackageGenerator::getTemplateLoadError() const
+{
+  return template_load_error_;
+}
+
+void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, const std::string& package_path) const
+{
+  FileSystemSink sink(package_path);
+  generatePackage(umrf, sink);
+  updateManifest(package_path, std::vector<UmrfNode>{umrf}, umrf.getPackageName(), false);
+}
+
+void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, OutputSink& sink) const
 {
   if (!file_templates_loaded_)
   {
-    std::cout << "Could not generate a TeMoto action package because the file templates are not loaded" << std::endl;
+    std::cout << "Could not generate a TeMoto action package because the file templates are not loaded: "
+      << template_load_error_ << std::endl;
     return;
   }
 
@@ -76,13 +310,18 @@ void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, const std::st
 
   // Get the name of the package
   const std::string ta_package_name = umrf.getPackageName();
-  const std::string ta_dst_path = package_path + "/" + ta_package_name + "/";
+  const std::string ta_dst_path = ta_package_name + "/";
+  GenerationProfiler::PackageScope package_scope(profiler_, ta_package_name);
 
   // Create a package directory
-  boost::filesystem::create_directories(ta_dst_path + "/src");
-  boost::filesystem::create_directories(ta_dst_path + "/launch");
-  boost::filesystem::create_directories(ta_dst_path + "/test");
-  boost::filesystem::create_directories(ta_dst_path + "/include/" + ta_package_name);
+  {
+    GenerationProfiler::ScopedTimer timer(profiler_, "create_directories");
+    sink.createDirectory(ta_dst_path + "src");
+    sink.createDirectory(ta_dst_path + "launch");
+    sink.createDirectory(ta_dst_path + "test");
+    sink.createDirectory(ta_dst_path + "bench");
+    sink.createDirectory(ta_dst_path + "include/" + ta_package_name);
+  }
 
   /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
    *                           GENERATE THE CONTENT
@@ -96,14 +335,168 @@ void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, const std::st
   /*
    * Generate umrf.json
    */
-  std::ofstream umrf_json_file;
-  umrf_json_file.open (ta_dst_path + "/umrf.json");
-  umrf_json_file << umrf_json_converter::toUmrfJsonStr(umrf, true);
-  umrf_json_file.close();
+  writeJson(sink, ta_dst_path + "umrf.json", umrf);
 
   /*
    * Generate invoker umrf graph
    */
+  generateInvokerGraph(umrf, sink, ta_dst_path + "test");
+
+  std::map<std::string, std::string> parameter_types;
+  collectParameterTypes(umrf, parameter_types);
+
+  /*
+   * Generate CMakeLists.txt and package.xml
+   */
+  generateBuildFiles(ta_package_name
+  , std::vector<std::string>{"src/" + ta_package_name + ".cpp"}
+  , getMessagePackages(parameter_types)
+  , sink
+  , ta_dst_path);
+
+  /*
+   * Generate invoke_action.launch 
+   */
+  TemplateArguments testlaunch_args;
+  testlaunch_args.set("ta_package_name", ta_package_name);
+  saveTemplate(t_testlaunch_separate, testlaunch_args, sink, ta_dst_path + "launch/invoke_action");
+
+  /*
+   * Generate the load test driver and its launch file
+   */
+  generateLoadTest(ta_package_name, ta_package_name, ta_class_name, sink, ta_dst_path);
+
+  /*
+   * Generate the binary parameter codec
+   */
+  const std::string codec_header = generateCodec(umrf, ta_package_name, sink, ta_dst_path + "include");
+  if (!codec_header.empty())
+  {
+    TemplateArguments codec_header_args;
+    codec_header_args.set("ta_package_name", ta_package_name);
+    saveTemplate(t_codec_header, codec_header_args, sink, ta_dst_path + "include/" + ta_package_name + "/parameter_codec");
+  }
+
+  /*
+   * Generate the microbenchmark harness
+   */
+  generateBench(umrf, codec_header, sink, ta_dst_path + "bench");
+
+  /*
+   * Generate the action implementation c++ source file
+   */
+  generateActionSource(umrf, ta_package_name, sink, ta_dst_path + "src/" + ta_package_name);
+
+  /*
+   * Generate the temoto_action header
+   */
+  generateBridgeHeader(ta_package_name
+  , parameter_types
+  , std::set<ActionVariant>{getActionVariant(umrf, true)}
+  , sink
+  , ta_dst_path + "include/" + ta_package_name);
+}
+
+std::vector<std::string> ActionPackageGenerator::generateBundle(const std::vector<UmrfNode>& umrfs
+, const std::string& bundle_name
+, const std::string& package_path) const
+{
+  FileSystemSink sink(package_path);
+  std::vector<std::string> skipped_umrfs = generateBundle(umrfs, bundle_name, sink);
+  updateManifest(package_path, umrfs, bundle_name, true);
+  return skipped_umrfs;
+}
+
+std::vector<std::string> ActionPackageGenerator::generateBundle(const std::vector<UmrfNode>& umrfs
+, const std::string& bundle_name
+, OutputSink& sink) const
+{
+  std::vector<std::string> skipped_umrfs;
+  if (!file_templates_loaded_)
+  {
+    std::cout << "Could not generate a TeMoto action bundle because the file templates are not loaded: "
+      << template_load_error_ << std::endl;
+    return skipped_umrfs;
+  }
+
+  const std::string bundle_dst_path = bundle_name + "/";
+  GenerationProfiler::PackageScope package_scope(profiler_, bundle_name);
+
+  // Create a package directory
+  {
+    GenerationProfiler::ScopedTimer timer(profiler_, "create_directories");
+    sink.createDirectory(bundle_dst_path + "src");
+    sink.createDirectory(bundle_dst_path + "umrf");
+    sink.createDirectory(bundle_dst_path + "launch");
+    sink.createDirectory(bundle_dst_path + "test");
+    sink.createDirectory(bundle_dst_path + "bench");
+    sink.createDirectory(bundle_dst_path + "include/" + bundle_name);
+  }
+
+  std::map<std::string, std::string> parameter_types;
+  std::set<std::string> bundled_class_names;
+  std::vector<std::string> sources;
+  std::vector<BundledAction> bundled_actions;
+  std::set<ActionVariant> variants;
+  bool has_codec = false;
+
+  for (const auto& umrf : umrfs)
+  {
+    const std::string ta_package_name = umrf.getPackageName();
+    const std::string ta_class_name = umrf.getName();
+
+    // All classes share one library, hence the class names have to be unique
+    if (!bundled_class_names.insert(ta_class_name).second)
+    {
+      skipped_umrfs.push_back(ta_package_name);
+      continue;
+    }
+
+    /*
+     * Generate the UMRF, the invoker graph, the benchmark and the action implementation
+     */
+    writeJson(sink, bundle_dst_path + "umrf/" + ta_package_name + ".umrf.json", umrf);
+    generateInvokerGraph(umrf, sink, bundle_dst_path + "test");
+    const std::string codec_header = generateCodec(umrf, bundle_name, sink, bundle_dst_path + "include");
+    has_codec = has_codec || !codec_header.empty();
+    generateBench(umrf, codec_header, sink, bundle_dst_path + "bench");
+    generateLoadTest(bundle_name, ta_package_name, ta_class_name, sink, bundle_dst_path);
+    generateActionSource(umrf, bundle_name, sink, bundle_dst_path + "src/" + ta_package_name);
+
+    collectParameterTypes(umrf, parameter_types);
+    sources.push_back("src/" + ta_package_name + ".cpp");
+    variants.insert(getActionVariant(umrf, true));
+
+    bundled_actions.push_back(BundledAction{ta_package_name, ta_class_name, "umrf/" + ta_package_name + ".umrf.json"});
+  }
+
+  /*
+   * Generate CMakeLists.txt and package.xml
+   */
+  generateBuildFiles(bundle_name, sources, getMessagePackages(parameter_types), sink, bundle_dst_path);
+
+  /*
+   * Generate the temoto_action header that is shared by all actions in the bundle
+   */
+  generateBridgeHeader(bundle_name, parameter_types, variants, sink, bundle_dst_path + "include/" + bundle_name);
+
+  if (has_codec)
+  {
+    TemplateArguments codec_header_args;
+    codec_header_args.set("ta_package_name", bundle_name);
+    saveTemplate(t_codec_header, codec_header_args, sink, bundle_dst_path + "include/" + bundle_name + "/parameter_codec");
+  }
+
+  /*
+   * Generate the manifest that maps each UMRF to its class in the bundle library
+   */
+  GenerationProfiler::ScopedTimer manifest_timer(profiler_, "write_file", "bundle_manifest.json");
+  sink.writeFile(bundle_dst_path + "bundle_manifest.json", toBundleManifestJson(bundle_name, bundled_actions));
+  return skipped_umrfs;
+}
+
+void ActionPackageGenerator::generateInvokerGraph(const UmrfNode& umrf, OutputSink& sink, const std::string& dst_path) const
+{
   UmrfNode invoker_umrf = umrf;
   invoker_umrf.getInputParametersNc().clear();
 
@@ -125,186 +518,342 @@ void ActionPackageGenerator::generatePackage(const UmrfNode& umrf, const std::st
   }
 
   invoker_umrf.setSuffix(0);
-  UmrfGraph invoker_umrf_graph(ta_package_name, std::vector<UmrfNode>{invoker_umrf});
-  generateGraph(invoker_umrf_graph, ta_dst_path + "/test");
+  UmrfGraph invoker_umrf_graph(umrf.getPackageName(), std::vector<UmrfNode>{invoker_umrf});
+  generateGraph(invoker_umrf_graph, sink, dst_path);
+}
 
-  /*
-   * Generate CMakeLists.txt
-   */
-  t_cmakelists.setArgument("ta_name", ta_package_name);
-  t_cmakelists.processAndSaveTemplate(ta_dst_path, "CMakeLists");
+void ActionPackageGenerator::generateBench(const UmrfNode& umrf
+, const std::string& codec_header
+, OutputSink& sink
+, const std::string& dst_path) const
+{
+  TemplateArguments bench_args;
+  bench_args.set("ta_package_name", umrf.getPackageName());
+  bench_args.set("ta_class_name", umrf.getName());
+  bench_args.set("codec_header", codec_header);
+  bench_args.setFlag("tick", getActionVariant(umrf) == ActionVariant::TICK);
+
+  // The buffer type of a shared parameter is known only at compile time
+  bench_args.declareList("shared_inputs");
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    if (isSharedType(input_param.getType()))
+    {
+      TemplateArguments& shared_args = bench_args.addListItem("shared_inputs");
+      shared_args.set("name", input_param.getName());
+      shared_args.set("type_us", toCppType(input_param.getType()));
+      shared_args.set("buffer_type", toCppType(getSharedType(input_param.getType())));
+    }
+  }
+  saveTemplate(t_bench, bench_args, sink, dst_path + "/" + umrf.getPackageName() + "_bench");
+}
 
-  /*
-   * Generate package.xml
-   */
-  t_packagexml.setArgument("ta_name", ta_package_name);
-  t_packagexml.processAndSaveTemplate(ta_dst_path, "package");
+void ActionPackageGenerator::generateLoadTest(const std::string& package_name
+, const std::string& ta_package_name
+, const std::string& ta_class_name
+, OutputSink& sink
+, const std::string& dst_path) const
+{
+  TemplateArguments load_test_args;
+  load_test_args.set("package_name", package_name);
+  load_test_args.set("ta_package_name", ta_package_name);
+  load_test_args.set("ta_class_name", ta_class_name);
+  saveTemplate(t_load_test, load_test_args, sink, dst_path + "test/" + ta_package_name + "_load_test");
+  saveTemplate(t_load_test_launch, load_test_args, sink, dst_path + "launch/" + ta_package_name + "_load_test");
+}
 
-  /*
-   * Generate the temoto_action header
-   */
-  t_bridge_header.setArgument("ta_package_name", ta_package_name);
-  std::ofstream bridge_header_file;
-  bridge_header_file.open (ta_dst_path + "/include/" + ta_package_name + "/temoto_action.h");
-  bridge_header_file << t_bridge_header.processTemplate();
-  bridge_header_file.close();
+void ActionPackageGenerator::generateBuildFiles(const std::string& package_name
+, const std::vector<std::string>& sources
+, const std::set<std::string>& message_packages
+, OutputSink& sink
+, const std::string& dst_path) const
+{
+  TemplateArguments cmakelists_args;
+  cmakelists_args.set("ta_name", package_name);
+  cmakelists_args.setFlag("fast_build", build_profile_ == BuildProfile::FAST_BUILD);
+  cmakelists_args.declareList("sources");
+  for (const auto& source : sources)
+  {
+    cmakelists_args.addListItem("sources").set("path", source);
+  }
 
-  /*
-   * Generate invoke_action.launch 
-   */
-  t_testlaunch_separate.setArgument("ta_package_name", ta_package_name);
-  t_testlaunch_separate.processAndSaveTemplate(ta_dst_path + "launch/", "invoke_action");
+  TemplateArguments packagexml_args;
+  packagexml_args.set("ta_name", package_name);
 
-  /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * 
-   * Generate the action implementation c++ source file
-   * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+  // The load test reports of the actions are std_msgs/String messages
+  std::set<std::string> dependencies = message_packages;
+  dependencies.insert("std_msgs");
 
-  std::string generated_content_cpp;
-  std::set<std::string> input_param_update_set;
+  cmakelists_args.declareList("message_packages");
+  packagexml_args.declareList("message_packages");
+  for (const auto& message_package : dependencies)
+  {
+    cmakelists_args.addListItem("message_packages").set("name", message_package);
+    packagexml_args.addListItem("message_packages").set("name", message_package);
+  }
+
+  saveTemplate(t_cmakelists, cmakelists_args, sink, dst_path + "CMakeLists");
+  saveTemplate(t_packagexml, packagexml_args, sink, dst_path + "package");
+}
+
+TemplateArguments ActionPackageGenerator::makeActionArguments(const UmrfNode& umrf
+, const std::string& header_package_name) const
+{
+  GenerationProfiler::ScopedTimer timer(profiler_, "prepare_arguments");
+  TemplateArguments args;
+  args.set("ta_class_name", umrf.getName());
+  args.set("ta_package_name", header_package_name);
+  args.declareList("input_parameters");
+  args.declareList("output_parameters");
+  args.declareList("input_channels");
+  args.declareList("message_headers");
 
-  /*
-   * Generate the "getInputParameters()" function
-   */
-  std::string gen_content_get_input_params;
   for (const auto& input_param : umrf.getInputParameters())
   {
-    std::string parameter_name = "in_param_" + input_param.getName();
-    boost::replace_all(parameter_name, "::", "_");
-    t_parameter_in.setArgument("param_name", input_param.getName());
-    t_parameter_in.setArgument("param_name_us", parameter_name);
-    t_parameter_in.setArgument("param_type", input_param.getType());
-    t_bridge_header_elif.setArgument("param_type", input_param.getType());
+    TemplateArguments& param_args = args.addListItem("input_parameters");
+    param_args.set("name", input_param.getName());
+    param_args.set("name_us", toMemberName("in_param_", input_param.getName()));
+    param_args.set("type", input_param.getType());
+    param_args.set("type_us", toCppType(input_param.getType()));
+    param_args.setFlag("batch_marker", input_param.getName() == "temoto_batch");
+  }
 
-    if (action_parameter::PARAMETER_MAP.find(input_param.getType()) != action_parameter::PARAMETER_MAP.end())
-    {
-      t_parameter_in.setArgument("param_type_us", action_parameter::PARAMETER_MAP.at(input_param.getType()));
-      t_bridge_header_elif.setArgument("param_type_us", action_parameter::PARAMETER_MAP.at(input_param.getType()));
-    }
-    else
+  // Topic parameters get a subscriber that feeds a channel
+  std::set<std::string> message_headers;
+  for (const auto& input_param : umrf.getInputParameters())
+  {
+    if (!isTopicType(input_param.getType()))
     {
-      t_parameter_in.setArgument("param_type_us", input_param.getType());
-      t_bridge_header_elif.setArgument("param_type_us", input_param.getType());
+      continue;
     }
-    gen_content_get_input_params += "  " + t_parameter_in.processTemplate() + "\n";
-    input_param_update_set.insert(t_bridge_header_elif.processTemplate());
+    const std::string message_type = getMessageType(input_param.getType());
+    TemplateArguments& channel_args = args.addListItem("input_channels");
+    channel_args.set("name", input_param.getName());
+    channel_args.set("topic", toMemberName("in_param_", input_param.getName()));
+    channel_args.set("channel", toMemberName("in_channel_", input_param.getName()));
+    channel_args.set("subscriber", toMemberName("in_subscriber_", input_param.getName()));
+    channel_args.set("callback", toMemberName("in_callback_", input_param.getName()));
+    channel_args.set("msg_type", message_type);
+    message_headers.insert(getMessageHeader(message_type));
+  }
+  for (const auto& message_header : message_headers)
+  {
+    args.addListItem("message_headers").set("path", message_header);
   }
-  t_get_input_params.setArgument("function_body", gen_content_get_input_params);
 
-  /*
-   * Generate the "setOutputParameters()" function
-   */
-  std::string gen_content_set_output_params;
   for (const auto& output_param : umrf.getOutputParameters())
   {
-    std::string parameter_name = "out_param_" + output_param.getName();
-    boost::replace_all(parameter_name, "::", "_");
-    t_parameter_out.setArgument("param_name_us", parameter_name);
-    t_parameter_out.setArgument("param_name", output_param.getName());
-    t_parameter_out.setArgument("param_type", output_param.getType());
+    TemplateArguments& param_args = args.addListItem("output_parameters");
+    param_args.set("name", output_param.getName());
+    param_args.set("name_us", toMemberName("out_param_", output_param.getName()));
+    param_args.set("type", output_param.getType());
+    param_args.set("type_us", toCppType(output_param.getType()));
+  }
 
-    // if (action_parameter::PARAMETER_MAP.find(output_param.getType()) != action_parameter::PARAMETER_MAP.end())
-    // {
-    //   t_parameter_out.setArgument("param_type_us", action_parameter::PARAMETER_MAP.at(output_param.getType()));
-    // }
-    // else
-    // {
-    //   t_parameter_out.setArgument("param_type_us", output_param.getType());
-    // }
+  // Periodic actions take the rate and the optional real-time priority from the input parameters
+  if (getActionVariant(umrf) == ActionVariant::TICK)
+  {
+    args.set("tick_rate", toMemberName("in_param_", "tick_rate"));
+    if (hasInputParameter(umrf, "tick_priority", "number"))
+    {
+      args.set("tick_priority", "static_cast<int>(" + toMemberName("in_param_", "tick_priority") + ")");
+    }
+  }
+
+  return args;
+}
 
-    gen_content_set_output_params += "  " + t_parameter_out.processTemplate() + "\n";
+void ActionPackageGenerator::generateActionSource(const UmrfNode& umrf
+, const std::string& header_package_name
+, OutputSink& sink
+, const std::string& dst_path) const
+{
+  const CompiledTemplate* t_class = &t_class_base;
+  switch (getActionVariant(umrf))
+  {
+    case ActionVariant::ASYNC:
+      t_class = &t_class_async;
+      break;
+    case ActionVariant::TICK:
+      t_class = &t_class_tick;
+      break;
+    case ActionVariant::BATCH:
+      t_class = &t_class_batch;
+      break;
+    default:
+      break;
   }
-  t_set_output_params.setArgument("function_body", gen_content_set_output_params);
+  saveTemplate(*t_class, makeActionArguments(umrf, header_package_name), sink, dst_path);
+}
 
-  /*
-   * Declare input parameters
-   */
-  std::string gen_content_input_param_decl;
-  if (!umrf.getInputParameters().empty())
+std::string ActionPackageGenerator::generateCodec(const UmrfNode& umrf
+, const std::string& header_package_name
+, OutputSink& sink
+, const std::string& include_path) const
+{
+  if (!hasParameterCodec(umrf))
   {
-    t_line_comment.setArgument("comment", "Declaration of input parameters");
-    t_line_comment.setArgument("whitespace", "\n");
-    gen_content_input_param_decl += t_line_comment.processTemplate();
+    return "";
+  }
+
+  const std::string codec_header = header_package_name + "/" + umrf.getPackageName() + "_codec";
+  TemplateArguments codec_args = makeActionArguments(umrf, header_package_name);
+  codec_args.set("codec_version", std::to_string(getSchemaVersion(umrf)) + "u");
+  saveTemplate(t_codec, codec_args, sink, include_path + "/" + codec_header);
+  return codec_header + t_codec.getExtension();
+}
 
-    for (const auto& input_param : umrf.getInputParameters())
+void ActionPackageGenerator::generateBridgeHeader(const std::string& package_name
+, const std::map<std::string, std::string>& parameter_types
+, const std::set<ActionVariant>& variants
+, OutputSink& sink
+, const std::string& dst_path) const
+{
+  TemplateArguments bridge_header_args;
+  bridge_header_args.set("ta_package_name", package_name);
+  bridge_header_args.setFlag("async", variants.count(ActionVariant::ASYNC) != 0);
+  bridge_header_args.setFlag("tick", variants.count(ActionVariant::TICK) != 0);
+  bridge_header_args.setFlag("batch", variants.count(ActionVariant::BATCH) != 0);
+  bridge_header_args.setFlag("channels", hasTopicParameters(parameter_types));
+  bridge_header_args.declareList("parameter_types");
+  bridge_header_args.declareList("message_headers");
+  for (const auto& parameter_type : parameter_types)
+  {
+    TemplateArguments& type_args = bridge_header_args.addListItem("parameter_types");
+    type_args.set("type", parameter_type.first);
+    type_args.set("type_us", parameter_type.second);
+  }
+
+  // The parameter types refer to the messages of the shared buffers, hence the header needs
+  // their definitions
+  for (const auto& parameter_type : parameter_types)
+  {
+    if (isSharedType(parameter_type.first) && isMessageType(getSharedType(parameter_type.first)))
     {
-      std::string parameter_name = "in_param_" + input_param.getName();
-      boost::replace_all(parameter_name, "::", "_");
-      t_parameter_decl.setArgument("param_name_us", parameter_name);
+      bridge_header_args.addListItem("message_headers").set("path", getMessageHeader(getSharedType(parameter_type.first)));
+    }
+  }
+  saveTemplate(t_bridge_header, bridge_header_args, sink, dst_path + "/temoto_action");
+}
 
-      if (action_parameter::PARAMETER_MAP.find(input_param.getType()) != action_parameter::PARAMETER_MAP.end())
+ActionPackageGenerator::ActionVariant ActionPackageGenerator::getActionVariant(const UmrfNode& umrf
+, bool report_warnings)
+{
+  if (umrf.getEffect() == "asynchronous")
+  {
+    return ActionVariant::ASYNC;
+  }
+  else if (hasInputParameter(umrf, "tick_rate"))
+  {
+    if (!hasInputParameter(umrf, "tick_rate", "number"))
+    {
+      if (report_warnings)
       {
-        t_parameter_decl.setArgument("param_type_us", action_parameter::PARAMETER_MAP.at(input_param.getType()));
+        std::cout << "Warning: the 'tick_rate' input parameter of action '" << umrf.getName()
+          << "' is not of type 'number', generating a blocking action" << std::endl;
       }
-      else
+      return ActionVariant::BLOCKING;
+    }
+
+    if (report_warnings && hasInputParameter(umrf, "tick_priority") && !hasInputParameter(umrf, "tick_priority", "number"))
+    {
+      std::cout << "Warning: the 'tick_priority' input parameter of action '" << umrf.getName()
+        << "' is not of type 'number' and is ignored" << std::endl;
+    }
+    return ActionVariant::TICK;
+  }
+  else if (hasInputParameter(umrf, "temoto_batch"))
+  {
+    if (!hasInputParameter(umrf, "temoto_batch", "bool"))
+    {
+      if (report_warnings)
       {
-        t_parameter_decl.setArgument("param_type_us", input_param.getType());
+        std::cout << "Warning: the 'temoto_batch' input parameter of action '" << umrf.getName()
+          << "' is not of type 'bool', generating a blocking action" << std::endl;
       }
-      gen_content_input_param_decl += t_parameter_decl.processTemplate() + "\n";
+      return ActionVariant::BLOCKING;
     }
+    return ActionVariant::BATCH;
   }
+  else
+  {
+    return ActionVariant::BLOCKING;
+  }
+}
 
-  /*
-   * Declare output parameters
-   */
-  std::string gen_content_output_param_decl;
-  if (!umrf.getOutputParameters().empty())
+void ActionPackageGenerator::saveTemplate(const CompiledTemplate& file_template
+, const TemplateArguments& args
+, OutputSink& sink
+, const std::string& file_path) const
+{
+  // The file is rendered straight into the sink, a sink that needs the size upfront buffers it
+  GenerationProfiler::ScopedTimer timer(profiler_, "render", file_template.getName());
+  std::ostream& out = sink.beginFile(file_path + file_template.getExtension(), OutputSink::UNKNOWN_SIZE);
+  file_template.render(args, out);
+  sink.endFile();
+}
+
+void ActionPackageGenerator::writeJson(OutputSink& sink, const std::string& file_path, const UmrfNode& umrf) const
+{
+  std::string umrf_json_str;
   {
-    t_line_comment.setArgument("comment", "Declaration of output parameters");
-    t_line_comment.setArgument("whitespace", "\n");
-    gen_content_output_param_decl += t_line_comment.processTemplate();
+    GenerationProfiler::ScopedTimer timer(profiler_, "serialize_umrf");
+    umrf_json_str = umrf_json_converter::toUmrfJsonStr(umrf, true);
+  }
 
-    for (const auto& output_param : umrf.getOutputParameters())
-    {
-      std::string parameter_name = "out_param_" + output_param.getName();
-      boost::replace_all(parameter_name, "::", "_");
-      t_parameter_decl.setArgument("param_name_us", parameter_name);
+  GenerationProfiler::ScopedTimer timer(profiler_, "write_file", "umrf.json");
+  sink.writeFile(file_path, umrf_json_str);
+}
 
-      if (action_parameter::PARAMETER_MAP.find(output_param.getType()) != action_parameter::PARAMETER_MAP.end())
-      {
-        t_parameter_decl.setArgument("param_type_us", action_parameter::PARAMETER_MAP.at(output_param.getType()));
-      }
-      else
-      {
-        t_parameter_decl.setArgument("param_type_us", output_param.getType());
-      }
-      gen_content_output_param_decl += t_parameter_decl.processTemplate() + "\n";
-    }
+void ActionPackageGenerator::updateManifest(const std::string& actions_path
+, const std::vector<UmrfNode>& umrfs
+, const std::string& package_name
+, bool bundle) const
+{
+  if (!file_templates_loaded_)
+  {
+    return;
   }
 
-  /*
-   * Put it all together and generate the whole class
-   */
-  t_class_base.setArgument("ta_class_name", ta_class_name);
-  t_class_base.setArgument("ta_package_name", ta_package_name);
-  t_class_base.setArgument("fn_get_input_parameters", t_get_input_params.processTemplate());
-  t_class_base.setArgument("fn_set_output_parameters", t_set_output_params.processTemplate());
-  t_class_base.setArgument("fn_execute_action", t_execute_action.processTemplate());
-  t_class_base.setArgument("class_members", gen_content_input_param_decl + gen_content_output_param_decl);
+  // The package itself has been generated, hence a manifest failure is only reported
+  try
+  {
+    GenerationProfiler::ScopedTimer timer(profiler_, "write_file", ACTION_MANIFEST_FILE_NAME);
+    updateActionManifest(actions_path, makeActionManifestEntries(umrfs, package_name, bundle));
+  }
+  catch (const std::exception& e)
+  {
+    std::cout << "Could not update the action manifest: " << e.what() << std::endl;
+  }
+}
 
-  /*
-   * Save the generated c++ content
-   */
-  tp::saveStrToFile(t_class_base.processTemplate(), ta_dst_path + "/src", ta_package_name, ".cpp");
+void ActionPackageGenerator::generateGraph(const UmrfGraph& umrf_graph, const std::string& graphs_path) const
+{
+  FileSystemSink sink(graphs_path);
+  generateGraph(umrf_graph, sink, "");
+}
 
-  /*
-   * Generate the temoto_action header
-   */
-  t_bridge_header.setArgument("ta_package_name", ta_package_name);
-  std::string elif_blocks;
-  for (const auto& elif_block : input_param_update_set)
+void ActionPackageGenerator::generateGraph(const UmrfGraph& umrf_graph
+, OutputSink& sink
+, const std::string& graphs_dir) const
+{
+  std::string umrf_graph_json_str;
   {
-    elif_blocks += elif_block;
+    GenerationProfiler::ScopedTimer timer(profiler_, "serialize_graph");
+    umrf_graph_json_str = umrf_json_converter::toUmrfGraphJsonStr(umrf_graph);
   }
-  t_bridge_header.setArgument("update_parameters_content", elif_blocks);
-  tp::saveStrToFile(t_bridge_header.processTemplate(), ta_dst_path + "/include/" + ta_package_name, "temoto_action", ".h");
 
+  GenerationProfiler::ScopedTimer timer(profiler_, "write_file", "umrfg.json");
+  sink.writeFile(graphs_dir + "/" + umrf_graph.getName() + ".umrfg.json", umrf_graph_json_str);
+}
+
+void ActionPackageGenerator::setProfiler(GenerationProfiler* profiler)
+{
+  profiler_ = profiler;
 }
 
-void ActionPackageGenerator::generateGraph(const UmrfGraph& umrf_graph, const std::string& graphs_path)
+GenerationProfiler* ActionPackageGenerator::getProfiler() const
 {
-  std::ofstream umrf_graph_json_file;
-  umrf_graph_json_file.open (graphs_path + "/" + umrf_graph.getName() + ".umrfg.json");
-  umrf_graph_json_file << umrf_json_converter::toUmrfGraphJsonStr(umrf_graph);
-  umrf_graph_json_file.close();
+  return profiler_;
 }
-}// temoto_action_assistant namespace
\ No newline at end of file
+}// temoto_action_assistant namespace
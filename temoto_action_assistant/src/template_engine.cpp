@@ -0,0 +1,680 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/template_engine.h"
+#include <fstream>
+#include <stdexcept>
+
+namespace temoto_action_assistant
+{
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * TemplateArguments
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void TemplateArguments::set(const std::string& name, const std::string& value)
+{
+  values_[name] = value;
+}
+
+void TemplateArguments::setFlag(const std::string& name, bool value)
+{
+  values_[name] = value ? "1" : "";
+}
+
+TemplateArguments& TemplateArguments::addListItem(const std::string& list_name)
+{
+  List& list = lists_[list_name];
+  list.emplace_back();
+  return list.back();
+}
+
+void TemplateArguments::declareList(const std::string& list_name)
+{
+  lists_[list_name];
+}
+
+const std::string* TemplateArguments::findValue(const std::string& name) const
+{
+  const auto it = values_.find(name);
+  return (it == values_.end()) ? nullptr : &it->second;
+}
+
+const TemplateArguments::List* TemplateArguments::findList(const std::string& name) const
+{
+  const auto it = lists_.find(name);
+  return (it == lists_.end()) ? nullptr : &it->second;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Template nodes and the parser
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct CompiledTemplate::Node
+{
+  enum class Kind
+  {
+    TEXT,
+    ARG,
+    FOR,
+    IF
+  };
+
+  Kind kind;
+  std::string text;       // TEXT: the text, ARG: the verbatim directive used as a fallback
+  std::string scope;      // ARG/IF/FOR: loop variable the name refers to, empty for top level
+  std::string name;       // ARG/IF: argument name, FOR: list name
+  std::string loop_var;   // FOR: name of the loop variable
+  bool negate = false;    // IF: "$(if !name)"
+  std::vector<Node> body;
+  std::vector<Node> else_body;
+};
+
+namespace
+{
+typedef CompiledTemplate::Node Node;
+
+struct Directive
+{
+  std::string keyword;
+  std::string argument;
+  std::size_t begin;
+  std::size_t end;
+};
+
+void splitScopedName(const std::string& full_name, std::string& scope, std::string& name)
+{
+  const std::size_t dot = full_name.find('.');
+  if (dot == std::string::npos)
+  {
+    scope.clear();
+    name = full_name;
+  }
+  else
+  {
+    scope = full_name.substr(0, dot);
+    name = full_name.substr(dot + 1);
+  }
+}
+
+std::string trim(const std::string& str)
+{
+  const std::size_t first = str.find_first_not_of(" \t");
+  if (first == std::string::npos)
+  {
+    return "";
+  }
+  const std::size_t last = str.find_last_not_of(" \t");
+  return str.substr(first, last - first + 1);
+}
+
+class Parser
+{
+public:
+  Parser(const std::string& text, const std::string& source_name)
+  : text_(text)
+  , source_name_(source_name)
+  , pos_(0)
+  {}
+
+  std::vector<Node> parse()
+  {
+    std::vector<Node> nodes;
+    std::string terminator = parseNodes(nodes);
+    if (!terminator.empty())
+    {
+      throw error("Unexpected '$(" + terminator + ")'");
+    }
+    return nodes;
+  }
+
+private:
+  const std::string& text_;
+  const std::string& source_name_;
+  std::size_t pos_;
+  std::size_t last_directive_pos_ = 0;
+
+  std::runtime_error error(const std::string& message) const
+  {
+    std::size_t line = 1;
+    for (std::size_t i = 0; i < last_directive_pos_ && i < text_.size(); i++)
+    {
+      if (text_[i] == '\n')
+      {
+        line++;
+      }
+    }
+    return std::runtime_error("Template " + source_name_ + ":" + std::to_string(line) + ": " + message);
+  }
+
+  /*
+   * Finds the next directive that the engine understands, starting from "from"
+   */
+  bool findDirective(std::size_t from, Directive& directive) const
+  {
+    std::size_t start = text_.find("$(", from);
+    while (start != std::string::npos)
+    {
+      const std::size_t close = text_.find(')', start + 2);
+      if (close == std::string::npos)
+      {
+        return false;
+      }
+
+      const std::string content = text_.substr(start + 2, close - start - 2);
+
+      // Nested "$(" means that this one is not ours, e.g., "$(find $(arg pkg))"
+      if (content.find("$(") == std::string::npos)
+      {
+        const std::size_t space = content.find(' ');
+        const std::string keyword = content.substr(0, space);
+        const std::string argument = (space == std::string::npos) ? "" : trim(content.substr(space + 1));
+
+        if (keyword == "arg" || keyword == "for" || keyword == "if"
+        || keyword == "else" || keyword == "endfor" || keyword == "endif")
+        {
+          directive.keyword = keyword;
+          directive.argument = argument;
+          directive.begin = start;
+          directive.end = close + 1;
+          return true;
+        }
+      }
+      start = text_.find("$(", start + 2);
+    }
+    return false;
+  }
+
+  /*
+   * If the control directive is the only content on its line, widens it to cover the
+   * indentation before it and the line break after it
+   */
+  void widenStandalone(Directive& directive) const
+  {
+    std::size_t line_begin = directive.begin;
+    while (line_begin > 0 && (text_[line_begin - 1] == ' ' || text_[line_begin - 1] == '\t'))
+    {
+      line_begin--;
+    }
+    if (line_begin != 0 && text_[line_begin - 1] != '\n')
+    {
+      return;
+    }
+
+    std::size_t line_end = directive.end;
+    while (line_end < text_.size() && (text_[line_end] == ' ' || text_[line_end] == '\t'))
+    {
+      line_end++;
+    }
+    if (line_end < text_.size() && text_[line_end] == '\r')
+    {
+      line_end++;
+    }
+    if (line_end < text_.size() && text_[line_end] != '\n')
+    {
+      return;
+    }
+
+    directive.begin = line_begin;
+    directive.end = (line_end < text_.size()) ? line_end + 1 : line_end;
+  }
+
+  static void appendText(std::vector<Node>& nodes, const std::string& text)
+  {
+    if (text.empty())
+    {
+      return;
+    }
+    if (!nodes.empty() && nodes.back().kind == Node::Kind::TEXT)
+    {
+      nodes.back().text += text;
+      return;
+    }
+    Node node;
+    node.kind = Node::Kind::TEXT;
+    node.text = text;
+    nodes.push_back(std::move(node));
+  }
+
+  /*
+   * Parses nodes until the end of the text or until a block terminating directive
+   * ("else", "endfor", "endif"), which is returned
+   */
+  std::string parseNodes(std::vector<Node>& nodes)
+  {
+    Directive directive;
+    while (findDirective(pos_, directive))
+    {
+      last_directive_pos_ = directive.begin;
+
+      if (directive.keyword == "arg")
+      {
+        appendText(nodes, text_.substr(pos_, directive.begin - pos_));
+        Node node;
+        node.kind = Node::Kind::ARG;
+        node.text = text_.substr(directive.begin, directive.end - directive.begin);
+        splitScopedName(directive.argument, node.scope, node.name);
+        if (node.name.empty())
+        {
+          throw error("Missing argument name");
+        }
+        nodes.push_back(std::move(node));
+        pos_ = directive.end;
+        continue;
+      }
+
+      widenStandalone(directive);
+      appendText(nodes, text_.substr(pos_, directive.begin - pos_));
+      pos_ = directive.end;
+
+      if (directive.keyword == "for")
+      {
+        // Expected format: "p in list"
+        const std::size_t in_pos = directive.argument.find(" in ");
+        if (in_pos == std::string::npos)
+        {
+          throw error("Expected '$(for <variable> in <list>)'");
+        }
+        Node node;
+        node.kind = Node::Kind::FOR;
+        node.loop_var = trim(directive.argument.substr(0, in_pos));
+        splitScopedName(trim(directive.argument.substr(in_pos + 4)), node.scope, node.name);
+        if (node.loop_var.empty() || node.name.empty())
+        {
+          throw error("Expected '$(for <variable> in <list>)'");
+        }
+        if (parseNodes(node.body) != "endfor")
+        {
+          throw error("Missing '$(endfor)' for list '" + node.name + "'");
+        }
+        nodes.push_back(std::move(node));
+      }
+      else if (directive.keyword == "if")
+      {
+        Node node;
+        node.kind = Node::Kind::IF;
+        std::string condition = directive.argument;
+        if (!condition.empty() && condition[0] == '!')
+        {
+          node.negate = true;
+          condition = trim(condition.substr(1));
+        }
+        splitScopedName(condition, node.scope, node.name);
+        if (node.name.empty())
+        {
+          throw error("Missing condition");
+        }
+
+        std::string terminator = parseNodes(node.body);
+        if (terminator == "else")
+        {
+          terminator = parseNodes(node.else_body);
+        }
+        if (terminator != "endif")
+        {
+          throw error("Missing '$(endif)' for condition '" + condition + "'");
+        }
+        nodes.push_back(std::move(node));
+      }
+      else
+      {
+        // "else", "endfor" or "endif" terminate the enclosing block
+        return directive.keyword;
+      }
+    }
+
+    appendText(nodes, text_.substr(pos_));
+    pos_ = text_.size();
+    return "";
+  }
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Rendering
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct SizeWriter
+{
+  std::size_t size = 0;
+  void write(const std::string& str)
+  {
+    size += str.size();
+  }
+};
+
+struct StringWriter
+{
+  std::string& out;
+  void write(const std::string& str)
+  {
+    out.append(str);
+  }
+};
+
+struct StreamWriter
+{
+  std::ostream& out;
+  void write(const std::string& str)
+  {
+    out.write(str.data(), str.size());
+  }
+};
+
+struct LoopFrame
+{
+  const std::string* loop_var;
+  const TemplateArguments* item;
+  std::size_t index;
+  std::size_t count;
+};
+
+class Renderer
+{
+public:
+  Renderer(const TemplateArguments& args, const std::map<std::string, std::string>& defaults)
+  : args_(args)
+  , defaults_(defaults)
+  {}
+
+  template <typename Writer>
+  void render(const std::vector<Node>& nodes, Writer& writer)
+  {
+    for (const Node& node : nodes)
+    {
+      switch (node.kind)
+      {
+        case Node::Kind::TEXT:
+          writer.write(node.text);
+          break;
+
+        case Node::Kind::ARG:
+        {
+          const std::string* value = findValue(node.scope, node.name);
+          if (value == nullptr && !node.scope.empty())
+          {
+            throw std::runtime_error("Template argument '" + node.scope + "." + node.name + "' is not set");
+          }
+          writer.write(value ? *value : node.text);
+          break;
+        }
+
+        case Node::Kind::FOR:
+        {
+          const TemplateArguments::List* list = findList(node.scope, node.name);
+          if (list == nullptr)
+          {
+            throw std::runtime_error("Template list '" + (node.scope.empty() ? "" : node.scope + ".")
+              + node.name + "' is not set");
+          }
+          for (std::size_t i = 0; i < list->size(); i++)
+          {
+            frames_.push_back(LoopFrame{&node.loop_var, &(*list)[i], i, list->size()});
+            render(node.body, writer);
+            frames_.pop_back();
+          }
+          break;
+        }
+
+        case Node::Kind::IF:
+        {
+          bool condition = isTrue(node.scope, node.name);
+          render((condition != node.negate) ? node.body : node.else_body, writer);
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  const TemplateArguments& args_;
+  const std::map<std::string, std::string>& defaults_;
+  std::vector<LoopFrame> frames_;
+  std::string loop_value_;
+
+  const LoopFrame* findFrame(const std::string& loop_var) const
+  {
+    for (auto it = frames_.rbegin(); it != frames_.rend(); it++)
+    {
+      if (*it->loop_var == loop_var)
+      {
+        return &(*it);
+      }
+    }
+    return nullptr;
+  }
+
+  const TemplateArguments* findScope(const std::string& scope) const
+  {
+    if (scope.empty())
+    {
+      return &args_;
+    }
+    const LoopFrame* frame = findFrame(scope);
+    return frame ? frame->item : nullptr;
+  }
+
+  const std::string* findValue(const std::string& scope, const std::string& name)
+  {
+    // Loop state of the innermost loop
+    if (scope == "loop" && !frames_.empty() && !findFrame("loop"))
+    {
+      const LoopFrame& frame = frames_.back();
+      if (name == "index")
+      {
+        loop_value_ = std::to_string(frame.index);
+        return &loop_value_;
+      }
+      else if (name == "first")
+      {
+        loop_value_ = (frame.index == 0) ? "1" : "";
+        return &loop_value_;
+      }
+      else if (name == "last")
+      {
+        loop_value_ = (frame.index + 1 == frame.count) ? "1" : "";
+        return &loop_value_;
+      }
+    }
+
+    const TemplateArguments* scope_args = findScope(scope);
+    if (scope_args == nullptr)
+    {
+      return nullptr;
+    }
+
+    const std::string* value = scope_args->findValue(name);
+    if (value == nullptr && scope.empty())
+    {
+      const auto default_it = defaults_.find(name);
+      if (default_it != defaults_.end())
+      {
+        return &default_it->second;
+      }
+    }
+    return value;
+  }
+
+  const TemplateArguments::List* findList(const std::string& scope, const std::string& name) const
+  {
+    const TemplateArguments* scope_args = findScope(scope);
+    return scope_args ? scope_args->findList(name) : nullptr;
+  }
+
+  bool isTrue(const std::string& scope, const std::string& name)
+  {
+    const TemplateArguments::List* list = findList(scope, name);
+    if (list != nullptr)
+    {
+      return !list->empty();
+    }
+    const std::string* value = findValue(scope, name);
+    return value != nullptr && !value->empty();
+  }
+};
+
+std::string xmlUnescape(std::string str)
+{
+  const std::vector<std::pair<std::string, std::string>> entities = {
+    {"&quot;", "\""}, {"&apos;", "'"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&amp;", "&"}};
+
+  for (const auto& entity : entities)
+  {
+    std::size_t pos = 0;
+    while ((pos = str.find(entity.first, pos)) != std::string::npos)
+    {
+      str.replace(pos, entity.first.size(), entity.second);
+      pos += entity.second.size();
+    }
+  }
+  return str;
+}
+
+/*
+ * Returns the value of the XML attribute "name" within "element", or an empty string
+ */
+std::string getXmlAttribute(const std::string& element, const std::string& name)
+{
+  const std::string key = " " + name + "=";
+  const std::size_t key_pos = element.find(key);
+  if (key_pos == std::string::npos)
+  {
+    return "";
+  }
+  const std::size_t quote_pos = key_pos + key.size();
+  if (quote_pos >= element.size())
+  {
+    return "";
+  }
+  const char quote = element[quote_pos];
+  const std::size_t value_end = element.find(quote, quote_pos + 1);
+  if (value_end == std::string::npos)
+  {
+    return "";
+  }
+  return xmlUnescape(element.substr(quote_pos + 1, value_end - quote_pos - 1));
+}
+} // anonymous namespace
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * CompiledTemplate
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+CompiledTemplate::CompiledTemplate()
+: nodes_(std::make_shared<const std::vector<Node>>())
+{}
+
+CompiledTemplate::CompiledTemplate(const std::string& template_text
+, const std::map<std::string, std::string>& defaults
+, const std::string& extension)
+: defaults_(defaults)
+, extension_(extension)
+{
+  const std::string source_name = "<string>";
+  nodes_ = std::make_shared<const std::vector<Node>>(Parser(template_text, source_name).parse());
+}
+
+CompiledTemplate CompiledTemplate::fromFile(const std::string& file_path)
+{
+  std::ifstream ifs(file_path);
+  if (!ifs.good())
+  {
+    throw std::runtime_error("Could not open the template file '" + file_path + "'");
+  }
+  std::string file_template_str;
+  file_template_str.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  return fromFileTemplateStr(file_template_str, file_path);
+}
+
+CompiledTemplate CompiledTemplate::fromFileTemplateStr(const std::string& file_template_str, const std::string& source_name)
+{
+  const std::size_t body_pos = file_template_str.find("<body>");
+  const std::size_t cdata_begin = file_template_str.find("<![CDATA[", body_pos);
+  const std::size_t cdata_end = file_template_str.rfind("]]>");
+  if (body_pos == std::string::npos || cdata_begin == std::string::npos || cdata_end == std::string::npos
+  || cdata_end < cdata_begin)
+  {
+    throw std::runtime_error("Template " + source_name + " has no '<body><![CDATA[ ... ]]>' section");
+  }
+
+  // The file extension is declared in the root element
+  std::string extension;
+  const std::size_t root_pos = file_template_str.find("<f_template");
+  if (root_pos != std::string::npos)
+  {
+    extension = getXmlAttribute(file_template_str.substr(root_pos, file_template_str.find('>', root_pos) - root_pos), "extension");
+  }
+
+  // Collect the argument defaults from the "<arg name=... default=... />" elements
+  std::map<std::string, std::string> defaults;
+  std::size_t arg_pos = file_template_str.find("<arg ");
+  while (arg_pos != std::string::npos && arg_pos < body_pos)
+  {
+    const std::size_t arg_end = file_template_str.find('>', arg_pos);
+    const std::string element = file_template_str.substr(arg_pos, arg_end - arg_pos);
+    const std::string name = getXmlAttribute(element, "name");
+    if (!name.empty())
+    {
+      defaults[name] = getXmlAttribute(element, "default");
+    }
+    arg_pos = file_template_str.find("<arg ", arg_end);
+  }
+
+  const std::string body = file_template_str.substr(cdata_begin + 9, cdata_end - cdata_begin - 9);
+
+  CompiledTemplate compiled_template;
+  compiled_template.defaults_ = defaults;
+  compiled_template.extension_ = extension;
+  compiled_template.name_ = source_name;
+  compiled_template.nodes_ = std::make_shared<const std::vector<Node>>(Parser(body, source_name).parse());
+  return compiled_template;
+}
+
+std::size_t CompiledTemplate::measure(const TemplateArguments& args) const
+{
+  SizeWriter writer;
+  Renderer(args, defaults_).render(*nodes_, writer);
+  return writer.size;
+}
+
+std::string CompiledTemplate::render(const TemplateArguments& args) const
+{
+  std::string out;
+  StringWriter writer{out};
+  Renderer(args, defaults_).render(*nodes_, writer);
+  return out;
+}
+
+void CompiledTemplate::render(const TemplateArguments& args, std::ostream& out) const
+{
+  StreamWriter writer{out};
+  Renderer(args, defaults_).render(*nodes_, writer);
+}
+
+const std::string& CompiledTemplate::getExtension() const
+{
+  return extension_;
+}
+
+const std::string& CompiledTemplate::getName() const
+{
+  return name_;
+}
+
+bool CompiledTemplate::empty() const
+{
+  return nodes_->empty();
+}
+
+} // temoto_action_assistant namespace
@@ -1,14 +1,22 @@
 #include "temoto_action_assistant/threaded_action_indexer.h"
+#include "temoto_action_engine/umrf_json_converter.h"
+#include <boost/filesystem.hpp>
 #include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
 
 namespace temoto_action_assistant
 {
 
 ThreadedActionIndexer::ThreadedActionIndexer(const std::string& temoto_actions_path)
+: temoto_actions_path_(temoto_actions_path)
 {
   if (!temoto_actions_path.empty())
   {
     action_indexer_.addActionPath(temoto_actions_path);
+    manifest_ = std::unique_ptr<MappedActionManifest>(new MappedActionManifest(temoto_actions_path));
   }
 
   indexing_thread_ = std::thread([this]{startIndexing();});
@@ -18,16 +26,162 @@ void ThreadedActionIndexer::startIndexing()
 {
   while (!stop_indexing_)
   {
-    action_indexer_.indexActions();
+    if (!indexManifest())
     {
+      action_indexer_.indexActions();
       std::lock_guard<std::mutex> umrfs_lock(umrfs_mutex_);
       umrfs_ = action_indexer_.getUmrfs();
-
     }
     std::this_thread::sleep_for(std::chrono::milliseconds(4000));
   }
 }
 
+bool ThreadedActionIndexer::indexManifest()
+{
+  if (!manifest_)
+  {
+    return false;
+  }
+
+  try
+  {
+    if (manifest_->refresh())
+    {
+      manifest_valid_ = false;
+      manifest_umrfs_.clear();
+      if (!manifest_->exists())
+      {
+        return false;
+      }
+
+      for (const auto& entry : manifest_->getEntries())
+      {
+        ManifestUmrf manifest_umrf;
+        manifest_umrf.package_directory = entry.umrf_path.substr(0, entry.umrf_path.find('/'));
+        manifest_umrf.umrf_path = entry.umrf_path;
+        manifest_umrf.umrf_hash = entry.umrf_hash;
+        manifest_umrf.umrf = umrf_json_converter::fromUmrfJsonStr(entry.umrf_json, true);
+        manifest_umrfs_.push_back(manifest_umrf);
+      }
+      manifest_valid_ = true;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cout << "Could not read the action manifest: " << e.what() << std::endl;
+    manifest_valid_ = false;
+    manifest_umrfs_.clear();
+  }
+
+  if (!manifest_valid_)
+  {
+    return false;
+  }
+
+  /*
+   * The manifest is not updated when a package is removed, added or edited by other means than
+   * the generator, hence the package directories and UMRF files are checked on every pass
+   */
+  std::set<std::string> listed_directories;
+  std::vector<UmrfNode> umrfs;
+  bool umrfs_changed = false;
+  for (auto& manifest_umrf : manifest_umrfs_)
+  {
+    boost::system::error_code error;
+    if (!boost::filesystem::is_directory(temoto_actions_path_ + "/" + manifest_umrf.package_directory, error))
+    {
+      continue;
+    }
+
+    listed_directories.insert(manifest_umrf.package_directory);
+    if (umrfMatchesManifest(manifest_umrf))
+    {
+      umrfs.push_back(manifest_umrf.umrf);
+    }
+    else
+    {
+      umrfs_changed = true;
+    }
+  }
+
+  // The UMRFs of the edited and unlisted packages are taken from the directory tree
+  if (umrfs_changed || hasUnlistedPackages(listed_directories))
+  {
+    action_indexer_.indexActions();
+    for (const auto& indexed_umrf : action_indexer_.getUmrfs())
+    {
+      const bool listed = std::any_of(umrfs.begin(), umrfs.end(), [&](const UmrfNode& umrf)
+      {
+        return umrf.getPackageName() == indexed_umrf.getPackageName();
+      });
+      if (!listed)
+      {
+        umrfs.push_back(indexed_umrf);
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> umrfs_lock(umrfs_mutex_);
+  umrfs_ = umrfs;
+  return true;
+}
+
+bool ThreadedActionIndexer::umrfMatchesManifest(ManifestUmrf& manifest_umrf) const
+{
+  const std::string umrf_path = temoto_actions_path_ + "/" + manifest_umrf.umrf_path;
+
+  // The file is hashed only when its size or modification time has changed
+  struct stat status;
+  if (::stat(umrf_path.c_str(), &status) != 0)
+  {
+    manifest_umrf.checked = false;
+    return false;
+  }
+
+  const std::int64_t modification_time_ns = std::int64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+  const std::uint64_t size = status.st_size;
+  if (manifest_umrf.checked
+  && manifest_umrf.modification_time_ns == modification_time_ns
+  && manifest_umrf.size == size)
+  {
+    return manifest_umrf.matches;
+  }
+
+  std::ifstream umrf_file(umrf_path, std::ios::in | std::ios::binary);
+  std::stringstream umrf_json;
+  umrf_json << umrf_file.rdbuf();
+
+  manifest_umrf.checked = umrf_file.good();
+  manifest_umrf.modification_time_ns = modification_time_ns;
+  manifest_umrf.size = size;
+  manifest_umrf.matches = manifest_umrf.checked && hashUmrfJson(umrf_json.str()) == manifest_umrf.umrf_hash;
+  return manifest_umrf.matches;
+}
+
+bool ThreadedActionIndexer::hasUnlistedPackages(const std::set<std::string>& listed_directories) const
+{
+  namespace fs = boost::filesystem;
+  boost::system::error_code iteration_error;
+  boost::system::error_code status_error;
+  for (fs::directory_iterator it(temoto_actions_path_, iteration_error), end
+  ; !iteration_error && it != end
+  ; it.increment(iteration_error))
+  {
+    const std::string directory = it->path().filename().string();
+    if (listed_directories.count(directory) != 0 || !fs::is_directory(it->path(), status_error))
+    {
+      continue;
+    }
+
+    // Packages have a umrf.json, bundles a "umrf" directory
+    if (fs::exists(it->path() / "umrf.json", status_error) || fs::is_directory(it->path() / "umrf", status_error))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 void ThreadedActionIndexer::stopIndexing()
 {
   stop_indexing_ = true;
@@ -59,6 +59,7 @@ ActionAssistantWidget::ActionAssistantWidget(QWidget* parent
 : QWidget(parent)
 , custom_parameter_map_(action_parameter::PARAMETER_MAP)
 , umrf_graph_name_("")
+, build_profile_(BuildProfile::DEFAULT)
 {
   // Read in the umrf
   if (args.count("du_path"))
@@ -97,6 +98,11 @@ ActionAssistantWidget::ActionAssistantWidget(QWidget* parent
     // TODO: Check if the given path is valid
   }
 
+  if (args.count("to_path"))
+  {
+    template_override_path_ = args["to_path"].as<std::string>();
+  }
+
   if (args.count("up_path"))
   {
     umrf_parameters_path_ = args["up_path"].as<std::string>();
@@ -104,6 +110,11 @@ ActionAssistantWidget::ActionAssistantWidget(QWidget* parent
     // TODO: Check if the given path is valid
   }
 
+  if (args.count("build_profile"))
+  {
+    build_profile_ = toBuildProfile(args["build_profile"].as<std::string>());
+  }
+
   // Initialize the action indexer
   action_indexer_ = std::make_shared<ThreadedActionIndexer>(temoto_actions_path_);
 
@@ -247,7 +258,8 @@ void ActionAssistantWidget::progressPastStartScreen()
   , umrfs_
   , temoto_actions_path_
   , temoto_graphs_path_
-  , file_templates_path_
+  , template_override_path_
+  , build_profile_
   , action_indexer_);
   main_content_->addWidget(gpw_);
 
@@ -0,0 +1,337 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/widgets/circle_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_set>
+
+namespace temoto_action_assistant
+{
+CircleGrid::CircleGrid(int cell_size)
+: cell_size_(std::max(cell_size, 1))
+, max_radius_(0)
+{}
+
+void CircleGrid::insert(const std::string& name, int x, int y, int radius)
+{
+  auto circle_it = circles_.find(name);
+  if (circle_it != circles_.end())
+  {
+    circle_it->second.radius = radius;
+    max_radius_ = std::max(max_radius_, radius);
+    move(name, x, y);
+    return;
+  }
+
+  circles_.insert({name, Circle{x, y, radius}});
+  max_radius_ = std::max(max_radius_, radius);
+  addToCell(name, x, y);
+}
+
+void CircleGrid::move(const std::string& name, int x, int y)
+{
+  auto circle_it = circles_.find(name);
+  if (circle_it == circles_.end())
+  {
+    return;
+  }
+
+  Circle& circle = circle_it->second;
+  if (toCell(circle.x) != toCell(x) || toCell(circle.y) != toCell(y))
+  {
+    removeFromCell(name, circle.x, circle.y);
+    addToCell(name, x, y);
+  }
+  circle.x = x;
+  circle.y = y;
+}
+
+void CircleGrid::remove(const std::string& name)
+{
+  auto circle_it = circles_.find(name);
+  if (circle_it == circles_.end())
+  {
+    return;
+  }
+  removeFromCell(name, circle_it->second.x, circle_it->second.y);
+  circles_.erase(circle_it);
+}
+
+void CircleGrid::clear()
+{
+  circles_.clear();
+  cells_.clear();
+  max_radius_ = 0;
+}
+
+std::string CircleGrid::findCircleAt(int x, int y) const
+{
+  const std::string* hit_name = nullptr;
+
+  for (int cell_x = toCell(x - max_radius_); cell_x <= toCell(x + max_radius_); cell_x++)
+  {
+    for (int cell_y = toCell(y - max_radius_); cell_y <= toCell(y + max_radius_); cell_y++)
+    {
+      auto cell_it = cells_.find(toCellKey(cell_x, cell_y));
+      if (cell_it == cells_.end())
+      {
+        continue;
+      }
+
+      for (const auto& name : cell_it->second)
+      {
+        const Circle& circle = circles_.at(name);
+        const std::int64_t x_diff = circle.x - x;
+        const std::int64_t y_diff = circle.y - y;
+        if (x_diff * x_diff + y_diff * y_diff <= std::int64_t(circle.radius) * circle.radius
+        && (hit_name == nullptr || name < *hit_name))
+        {
+          hit_name = &name;
+        }
+      }
+    }
+  }
+
+  return hit_name == nullptr ? std::string() : *hit_name;
+}
+
+std::vector<std::string> CircleGrid::findCirclesInRect(int left, int top, int right, int bottom) const
+{
+  std::vector<std::string> names;
+  for (int cell_x = toCell(std::min(left, right)); cell_x <= toCell(std::max(left, right)); cell_x++)
+  {
+    for (int cell_y = toCell(std::min(top, bottom)); cell_y <= toCell(std::max(top, bottom)); cell_y++)
+    {
+      auto cell_it = cells_.find(toCellKey(cell_x, cell_y));
+      if (cell_it == cells_.end())
+      {
+        continue;
+      }
+
+      for (const auto& name : cell_it->second)
+      {
+        const Circle& circle = circles_.at(name);
+        if (circle.x >= std::min(left, right) && circle.x <= std::max(left, right)
+        && circle.y >= std::min(top, bottom) && circle.y <= std::max(top, bottom))
+        {
+          names.push_back(name);
+        }
+      }
+    }
+  }
+  return names;
+}
+
+void CircleGrid::findCirclesNear(int x, int y, int distance, std::vector<std::string>& names) const
+{
+  const std::int64_t max_distance_sq = std::int64_t(distance) * distance;
+  for (int cell_x = toCell(x - distance); cell_x <= toCell(x + distance); cell_x++)
+  {
+    for (int cell_y = toCell(y - distance); cell_y <= toCell(y + distance); cell_y++)
+    {
+      auto cell_it = cells_.find(toCellKey(cell_x, cell_y));
+      if (cell_it == cells_.end())
+      {
+        continue;
+      }
+
+      for (const auto& name : cell_it->second)
+      {
+        const Circle& circle = circles_.at(name);
+        const std::int64_t x_diff = circle.x - x;
+        const std::int64_t y_diff = circle.y - y;
+        if (x_diff * x_diff + y_diff * y_diff <= max_distance_sq)
+        {
+          names.push_back(name);
+        }
+      }
+    }
+  }
+}
+
+bool CircleGrid::getPosition(const std::string& name, int& x, int& y) const
+{
+  auto circle_it = circles_.find(name);
+  if (circle_it == circles_.end())
+  {
+    return false;
+  }
+  x = circle_it->second.x;
+  y = circle_it->second.y;
+  return true;
+}
+
+bool CircleGrid::resolveOverlaps(const std::vector<std::string>& seed_names
+, bool pin_seeds
+, int spacing
+, int max_passes
+, std::vector<std::string>& moved_names)
+{
+  std::unordered_set<std::string> pinned_names;
+  std::unordered_set<std::string> moved_name_set;
+  std::vector<std::string> active_names;
+  for (const auto& seed_name : seed_names)
+  {
+    if (circles_.find(seed_name) == circles_.end())
+    {
+      continue;
+    }
+    if (pin_seeds)
+    {
+      pinned_names.insert(seed_name);
+    }
+    active_names.push_back(seed_name);
+  }
+
+  std::vector<std::string> neighbour_names;
+  std::unordered_set<std::string> next_active_names;
+
+  /*
+   * Moves the circle by the given offset and marks it active for the next pass. The offset is
+   * rounded away from zero, so that every push makes progress on the integer grid.
+   */
+  auto push = [&](const std::string& name, double x_offset, double y_offset)
+  {
+    Circle& circle = circles_.at(name);
+    move(name
+    , circle.x + static_cast<int>(x_offset < 0 ? std::floor(x_offset) : std::ceil(x_offset))
+    , circle.y + static_cast<int>(y_offset < 0 ? std::floor(y_offset) : std::ceil(y_offset)));
+
+    next_active_names.insert(name);
+    if (moved_name_set.insert(name).second)
+    {
+      moved_names.push_back(name);
+    }
+  };
+
+  for (int pass = 0; pass < max_passes && !active_names.empty(); pass++)
+  {
+    next_active_names.clear();
+
+    for (const auto& name : active_names)
+    {
+      const Circle& circle = circles_.at(name);
+      neighbour_names.clear();
+      findCirclesNear(circle.x, circle.y, circle.radius + max_radius_, neighbour_names);
+
+      for (const auto& neighbour_name : neighbour_names)
+      {
+        if (neighbour_name == name)
+        {
+          continue;
+        }
+
+        const Circle& neighbour = circles_.at(neighbour_name);
+        const std::int64_t x_diff = neighbour.x - circle.x;
+        const std::int64_t y_diff = neighbour.y - circle.y;
+        const std::int64_t min_distance = circle.radius + neighbour.radius;
+        if (x_diff * x_diff + y_diff * y_diff >= min_distance * min_distance)
+        {
+          continue;
+        }
+
+        const bool circle_pinned = pinned_names.count(name) != 0;
+        const bool neighbour_pinned = pinned_names.count(neighbour_name) != 0;
+        if (circle_pinned && neighbour_pinned)
+        {
+          continue;
+        }
+
+        // Circles on the same spot are separated in a direction that is stable for the pair
+        double distance = std::sqrt(double(x_diff * x_diff + y_diff * y_diff));
+        double x_direction;
+        double y_direction;
+        if (distance > 0)
+        {
+          x_direction = x_diff / distance;
+          y_direction = y_diff / distance;
+        }
+        else
+        {
+          const double angle = std::hash<std::string>()(neighbour_name) % 360 * M_PI / 180;
+          x_direction = std::cos(angle);
+          y_direction = std::sin(angle);
+        }
+
+        const double overlap = min_distance + spacing - distance;
+        if (circle_pinned)
+        {
+          push(neighbour_name, overlap * x_direction, overlap * y_direction);
+        }
+        else if (neighbour_pinned)
+        {
+          push(name, -overlap * x_direction, -overlap * y_direction);
+        }
+        else
+        {
+          push(neighbour_name, overlap / 2 * x_direction, overlap / 2 * y_direction);
+          push(name, -overlap / 2 * x_direction, -overlap / 2 * y_direction);
+        }
+      }
+    }
+
+    active_names.assign(next_active_names.begin(), next_active_names.end());
+  }
+
+  return active_names.empty();
+}
+
+std::size_t CircleGrid::size() const
+{
+  return circles_.size();
+}
+
+int CircleGrid::toCell(int coordinate) const
+{
+  // Rounds towards negative infinity, the circles can be dragged to negative coordinates
+  return coordinate >= 0 ? coordinate / cell_size_ : -((-coordinate + cell_size_ - 1) / cell_size_);
+}
+
+std::int64_t CircleGrid::toCellKey(int cell_x, int cell_y)
+{
+  return (std::int64_t(cell_x) << 32) | std::uint32_t(cell_y);
+}
+
+void CircleGrid::addToCell(const std::string& name, int x, int y)
+{
+  cells_[toCellKey(toCell(x), toCell(y))].push_back(name);
+}
+
+void CircleGrid::removeFromCell(const std::string& name, int x, int y)
+{
+  auto cell_it = cells_.find(toCellKey(toCell(x), toCell(y)));
+  if (cell_it == cells_.end())
+  {
+    return;
+  }
+
+  std::vector<std::string>& names = cell_it->second;
+  auto name_it = std::find(names.begin(), names.end(), name);
+  if (name_it != names.end())
+  {
+    // The order within a cell does not matter
+    std::swap(*name_it, names.back());
+    names.pop_back();
+  }
+  if (names.empty())
+  {
+    cells_.erase(cell_it);
+  }
+}
+
+} // temoto_action_assistant namespace
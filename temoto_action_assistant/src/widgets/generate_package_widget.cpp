@@ -33,13 +33,19 @@
  *********************************************************************/
 
 #include "temoto_action_assistant/widgets/generate_package_widget.h"
+#include "temoto_action_assistant/package_regenerator.h"
 #include "temoto_action_engine/umrf_json_converter.h"
 #include "std_msgs/String.h"
 
 #include <QVBoxLayout>
+#include <QApplication>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QFontDatabase>
 #include <QFormLayout>
 #include <QMessageBox>
+#include <QPlainTextEdit>
 
 #include <boost/algorithm/string.hpp>
 #include <iostream>
@@ -55,16 +61,20 @@ GeneratePackageWidget::GeneratePackageWidget( QWidget* parent
 , std::vector<std::shared_ptr<UmrfNode>>& umrfs
 , std::string temoto_actions_path
 , std::string temoto_graphs_path
-, std::string file_template_path
+, std::string template_override_path
+, BuildProfile build_profile
 , std::shared_ptr<ThreadedActionIndexer> action_indexer)
 : SetupScreenWidget(parent),
   umrf_graph_name_(umrf_graph_name),
   umrfs_(umrfs),
-  apg_(file_template_path),
+  apg_(template_override_path, build_profile),
   temoto_actions_path_(temoto_actions_path),
   temoto_graphs_path_(temoto_graphs_path),
   action_indexer_(action_indexer)
 {
+  // Time every generation run, the report is shown once the packages are generated
+  apg_.setProfiler(&profiler_);
+
   // Layout for "add/remove selected" buttons
   QVBoxLayout* layout = new QVBoxLayout(this);
 
@@ -115,6 +125,13 @@ GeneratePackageWidget::GeneratePackageWidget( QWidget* parent
   graphs_path_layout->addWidget(btn_graphs_dir_);
   form_layout->addRow("Graphs Path:", graphs_path_layout);
 
+  /*
+   * Add the bundle mode checkbox
+   */
+  bundle_checkbox_ = new QCheckBox("Bundle all actions into a single package and library", this);
+  bundle_checkbox_->setChecked(false);
+  form_layout->addRow("Bundle:", bundle_checkbox_);
+
   layout->addLayout(form_layout);
   layout->addSpacerItem(new QSpacerItem(1,50, QSizePolicy::Expanding, QSizePolicy::Fixed));
 
@@ -132,6 +149,16 @@ GeneratePackageWidget::GeneratePackageWidget( QWidget* parent
     btn_generate_package_->setEnabled(false);
   }
 
+  /*
+   * Dry run Button, shows how the existing packages would change if they were regenerated
+   * with the current templates
+   */
+  btn_dry_run_ = new QPushButton("&Dry Run Regeneration", this);
+  btn_dry_run_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+  connect(btn_dry_run_, SIGNAL(clicked()), this, SLOT(dryRunRegeneration()));
+  layout->addWidget(btn_dry_run_);
+  layout->setAlignment(btn_dry_run_, Qt::AlignCenter);
+
   layout->addStretch();
   this->setLayout(layout);
 }
@@ -182,6 +209,45 @@ void GeneratePackageWidget::setGraphsPath()
   }
 }
 
+// ******************************************************************************************
+//
+// ******************************************************************************************
+void GeneratePackageWidget::dryRunRegeneration()
+{
+  if (temoto_actions_path_.empty())
+  {
+    QMessageBox::warning(this, "Dry Run", "The actions path is not set");
+    return;
+  }
+
+  // Render all packages in memory and compare them against the ones on disk
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  PackageRegenerator regenerator(apg_, temoto_actions_path_);
+  const DryRunReport report = regenerator.dryRun();
+  QApplication::restoreOverrideCursor();
+
+  /*
+   * Show the report in a dialog
+   */
+  QDialog dialog(this);
+  dialog.setWindowTitle("Dry Run Regeneration");
+  dialog.resize(900, 600);
+  QVBoxLayout* dialog_layout = new QVBoxLayout(&dialog);
+
+  QPlainTextEdit* report_field = new QPlainTextEdit(&dialog);
+  report_field->setReadOnly(true);
+  report_field->setLineWrapMode(QPlainTextEdit::NoWrap);
+  report_field->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  report_field->setPlainText(QString::fromStdString(PackageRegenerator::formatReport(report)));
+  dialog_layout->addWidget(report_field);
+
+  QDialogButtonBox* button_box = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+  connect(button_box, SIGNAL(rejected()), &dialog, SLOT(reject()));
+  dialog_layout->addWidget(button_box);
+
+  dialog.exec();
+}
+
 // ******************************************************************************************
 //
 // ******************************************************************************************
@@ -195,6 +261,8 @@ void GeneratePackageWidget::generateUmrfGraph() const
 // ******************************************************************************************
 void GeneratePackageWidget::generatePackages()
 {
+  profiler_.clear();
+
   // Make a copy of the original UMRFs
   std::vector<UmrfNode> umrfs_copy;
   for (const auto& original_umrf_ptr : umrfs_)
@@ -212,6 +280,7 @@ void GeneratePackageWidget::generatePackages()
 
   // Check the names of the UMRFs before proceeding further
   // TODO: Make sure that there isnt any other ros packages with the same name
+  GenerationProfiler::ScopedTimer prepare_timer(&profiler_, "prepare_umrfs");
   for (auto& umrf_cpy : umrfs_copy)
   {
     if (umrf_cpy.getName().empty())
@@ -245,11 +314,16 @@ void GeneratePackageWidget::generatePackages()
       umrf_cpy.addChild(UmrfNode::Relation(convertToClassName(child_relation.getName()), child_relation.getSuffix()));
     }
   }
+  prepare_timer.stop();
 
   // Generate the UMRF graph
-  UmrfGraph umrf_graph(umrf_graph_name_, umrfs_copy);
-  apg_.generateGraph(umrf_graph, temoto_graphs_path_);
+  {
+    GenerationProfiler::ScopedTimer timer(&profiler_, "generate_graph", umrf_graph_name_);
+    UmrfGraph umrf_graph(umrf_graph_name_, umrfs_copy);
+    apg_.generateGraph(umrf_graph, temoto_graphs_path_);
+  }
   unsigned int ignored_umrfs = 0;
+  std::vector<UmrfNode> bundled_umrfs;
 
   // Generate TeMoto action packages
   for (auto& umrf_cpy : umrfs_copy)
@@ -271,8 +345,30 @@ void GeneratePackageWidget::generatePackages()
       input_param.setExample("");
     }
 
-    // Generate the TeMoto action package
-    apg_.generatePackage(umrf_cpy, temoto_actions_path_);
+    // Generate the TeMoto action package or collect it for the bundle
+    if (bundle_checkbox_->isChecked())
+    {
+      bundled_umrfs.push_back(umrf_cpy);
+    }
+    else
+    {
+      apg_.generatePackage(umrf_cpy, temoto_actions_path_);
+    }
+  }
+
+  if (!bundled_umrfs.empty())
+  {
+    std::string bundle_name = convertToPackageName(umrf_graph_name_.empty() ? "bundle" : umrf_graph_name_ + " bundle");
+    const std::vector<std::string> skipped_umrfs = apg_.generateBundle(bundled_umrfs, bundle_name, temoto_actions_path_);
+
+    std::string message = "A TeMoto Action bundle '" + bundle_name + "' with "
+      + std::to_string(bundled_umrfs.size() - skipped_umrfs.size()) + " actions was generated successfully";
+    for (const auto& skipped_umrf : skipped_umrfs)
+    {
+      message += "\nSkipped '" + skipped_umrf + "' because the bundle already contains an action with the same name";
+    }
+    showGenerationReport(message);
+    return;
   }
 
   std::string message;
@@ -286,9 +382,36 @@ void GeneratePackageWidget::generatePackages()
     message = std::to_string(umrfs_.size()) + " TeMoto Action packages were generated successfully";
   }
 
+  showGenerationReport(message);
+}
+
+// ******************************************************************************************
+//
+// ******************************************************************************************
+void GeneratePackageWidget::showGenerationReport(const std::string& message)
+{
   QMessageBox msg_box;
   msg_box.setText(message.c_str());
+  msg_box.setDetailedText(QString::fromStdString(profiler_.formatReport()));
+  QPushButton* btn_save_trace = msg_box.addButton("Save &Trace...", QMessageBox::ActionRole);
+  msg_box.addButton(QMessageBox::Ok);
   msg_box.exec();
+
+  if (msg_box.clickedButton() != btn_save_trace)
+  {
+    return;
+  }
+
+  // Save the timeline of the generation, it can be viewed in chrome://tracing
+  QString trace_path = QFileDialog::getSaveFileName(this
+  , tr("Save Generation Trace")
+  , "generation_trace.json"
+  , tr("Chrome Trace (*.json)"));
+
+  if (!trace_path.isEmpty() && !profiler_.writeChromeTrace(trace_path.toStdString()))
+  {
+    QMessageBox::warning(this, "Save Trace", "Could not write the trace to '" + trace_path + "'");
+  }
 }
 
 // ******************************************************************************************
@@ -15,6 +15,7 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "temoto_action_assistant/widgets/parameter_edit_widget.h"
+#include "temoto_action_assistant/parameter_types.h"
 #include "temoto_action_engine/action_parameter.h"
 
 #include <QVBoxLayout>
@@ -122,6 +123,13 @@ void ParameterEditWidget::focusGiven(QTreeWidgetItem* tree_item_ptr)
    * Update the type field
    */
   int index = parameter_type_field_->findText(parameter->getType().c_str());
+  if (index == -1 && (isSharedType(parameter->getType()) || isTopicType(parameter->getType())))
+  {
+    // Shared buffer and topic types are declared per UMRF, hence they are not known in advance
+    addType(parameter->getType());
+    index = parameter_type_field_->findText(parameter->getType().c_str());
+  }
+
   if (index == -1)
   {
     // TODO: Throw an error
@@ -143,6 +151,16 @@ void ParameterEditWidget::createRightClickMenu(const QPoint& pos)
   connect(add_parameter_action, SIGNAL(triggered()), this, SLOT(addTypeDialog()));
   menu.addAction(add_parameter_action);
 
+  QAction* add_shared_parameter_action = new QAction(tr("ADD &Shared Buffer Type"), this);
+  add_shared_parameter_action->setIcon(this->style()->standardIcon(this->style()->SP_DialogApplyButton));
+  connect(add_shared_parameter_action, SIGNAL(triggered()), this, SLOT(addSharedTypeDialog()));
+  menu.addAction(add_shared_parameter_action);
+
+  QAction* add_topic_parameter_action = new QAction(tr("ADD &Topic Type"), this);
+  add_topic_parameter_action->setIcon(this->style()->standardIcon(this->style()->SP_DialogApplyButton));
+  connect(add_topic_parameter_action, SIGNAL(triggered()), this, SLOT(addTopicTypeDialog()));
+  menu.addAction(add_topic_parameter_action);
+
   // Create the menu where the cursor is
   QPoint pt(pos);
   menu.exec(parameter_type_field_->mapToGlobal(pos));
@@ -164,9 +182,62 @@ void ParameterEditWidget::addTypeDialog()
   if (ok_clicked && !text.isEmpty())
   {
     std::cout << "Adding custom parameter type: " << text.toStdString() << std::endl;
-    (*custom_parameter_map_)[text.toStdString()] = text.toStdString();
-    parameter_type_field_->addItem(text.toStdString().c_str());
+    addType(text.toStdString());
+  }
+}
+
+// ******************************************************************************************
+// 
+// ******************************************************************************************
+void ParameterEditWidget::addSharedTypeDialog()
+{
+  bool ok_clicked;
+  QString text = QInputDialog::getText(this
+  , tr("Add Shared Buffer Parameter")
+  , tr("Enter the C++ type of the buffer, e.g. sensor_msgs::PointCloud2.\n"
+       "The parameter is passed as std::shared_ptr<const TYPE>, i.e., without copying:")
+  , QLineEdit::Normal
+  , tr("<MY_TYPE>")
+  , &ok_clicked);
+
+  if (ok_clicked && !text.isEmpty())
+  {
+    std::string shared_type = toSharedType(text.toStdString());
+    std::cout << "Adding shared parameter type: " << shared_type << std::endl;
+    addType(shared_type);
+  }
+}
+
+// ******************************************************************************************
+// 
+// ******************************************************************************************
+void ParameterEditWidget::addTopicTypeDialog()
+{
+  bool ok_clicked;
+  QString text = QInputDialog::getText(this
+  , tr("Add Topic Parameter")
+  , tr("Enter the ROS message type of the topic, e.g. sensor_msgs::LaserScan.\n"
+       "The parameter holds the topic name, the messages are received through a lock-free channel:")
+  , QLineEdit::Normal
+  , tr("<MY_MSG_TYPE>")
+  , &ok_clicked);
+
+  if (ok_clicked && !text.isEmpty())
+  {
+    std::string topic_type = toTopicType(text.toStdString());
+    std::cout << "Adding topic parameter type: " << topic_type << std::endl;
+    addType(topic_type);
+  }
+}
+
+void ParameterEditWidget::addType(const std::string& parameter_type)
+{
+  if (custom_parameter_map_->count(parameter_type) != 0)
+  {
+    return;
   }
+  (*custom_parameter_map_)[parameter_type] = toCppType(parameter_type);
+  parameter_type_field_->addItem(parameter_type.c_str());
 }
 
 void ParameterEditWidget::refreshTreeItemText(const ActionParameters::ParameterContainer* const parameter)
@@ -20,11 +20,33 @@
 #include <QHBoxLayout>
 #include <QFormLayout>
 #include <QMenu>
+#include <QPaintEvent>
+#include <QFontMetrics>
 #include <iostream>
 #include <math.h>
 
 namespace temoto_action_assistant
 {
+namespace
+{
+/// Side length of a circle grid cell, slightly larger than the diameter of a circle
+const int CIRCLE_GRID_CELL_SIZE = 64;
+
+/// Gap between the circles that were pushed apart
+const int CIRCLE_SPACING = 10;
+
+/// Upper bound of the overlap relaxation passes, keeps a drop responsive on any graph
+const int MAX_OVERLAP_PASSES = 64;
+
+/// Margin around the painted items, covers the pen width and antialiasing
+const int PAINT_MARGIN = 3;
+
+QString getCircleLabel(const CircleHelper& circle)
+{
+  std::string label = circle.getUmrfName() + " " + std::to_string(circle.umrf_->getSuffix());
+  return QString(label.c_str());
+}
+}
 
 // ******************************************************************************************
 // Constructor
@@ -40,7 +62,12 @@ UmrfGraphWidget::UmrfGraphWidget(QWidget *parent
 , selected_circle_("")
 , circle_dropped_(true)
 , circle_uniqueness_counter_(0)
+, circle_grid_(CIRCLE_GRID_CELL_SIZE)
+, static_layer_dirty_(true)
 {
+  label_font_.setPixelSize(12);
+  description_font_.setPixelSize(9);
+
   QVBoxLayout* v_box_layout = new QVBoxLayout(parent);
   v_box_layout->setContentsMargins(0, 0, 0, 0);
   
@@ -52,27 +79,40 @@ UmrfGraphWidget::UmrfGraphWidget(QWidget *parent
   {
     // TODO: Pass as lvalue reference
     std::string unique_circle_name = getUniqueCircleName();
-    circles_.insert({unique_circle_name, CircleHelper(umrf, unique_circle_name, 170, 80, 25)});
+    insertCircle(CircleHelper(umrf, unique_circle_name, 170, 80, 25));
   }
+
+  // All loaded circles start on the same spot, spread them out
+  std::vector<std::string> circle_names;
+  for (const auto& circle : circles_)
+  {
+    circle_names.push_back(circle.first);
+  }
+  resolveOverlaps(circle_names, false);
 }
 
-void UmrfGraphWidget::drawGraph()
+void UmrfGraphWidget::renderStaticLayer()
 {
-  QPainter painter(this);
+  const qreal pixel_ratio = devicePixelRatioF();
+  if (static_layer_.size() != size() * pixel_ratio)
+  {
+    static_layer_ = QPixmap(size() * pixel_ratio);
+    static_layer_.setDevicePixelRatio(pixel_ratio);
+  }
+  static_layer_.fill(Qt::transparent);
+
+  QPainter painter(&static_layer_);
   painter.setRenderHint(QPainter::Antialiasing,true);
-  painter.setBrush(Qt::darkGray);
 
-  // First draw the lines, so that the lines will always be below circles
+  // First draw the lines, so that the lines will always be below circles. The dragged circle
+  // and its connections are drawn on top of the layer in paintEvent
   for (const auto& circle : circles_)
   {
-    QPen line_pen(Qt::darkGray, 2);
-    QPen arrow_pen;
-    arrow_pen.setStyle(Qt::PenStyle::NoPen);
-
-    // Draw the connection lines
     for (const auto& connection : circle.second.connections_)
     {
-      if (connection.direction_ != CircleHelper::ConnectionHelper::Direction::OUTBOUND)
+      if (connection.direction_ != CircleHelper::ConnectionHelper::Direction::OUTBOUND
+      || circle.first == dragged_circle_
+      || connection.other_circle_name_ == dragged_circle_)
       {
         continue;
       }
@@ -81,84 +121,202 @@ void UmrfGraphWidget::drawGraph()
         std::cout << "Cannot find cirle '" << connection.other_circle_name_ << "'" << std::endl;
         continue;
       }
-      
-      painter.setPen(line_pen);
-      painter.drawLine(circle.second.x_
-      , circle.second.y_
-      , circles_[connection.other_circle_name_].x_
-      , circles_[connection.other_circle_name_].y_);
-
-      // Build and draw the arrow head
-      float direction = circle.second.getRelativeDirection(circles_[connection.other_circle_name_]);
-      float distance = circle.second.getRelativeDistance(circles_[connection.other_circle_name_]);
-      float arrow_length = 14;
-      float other_circle_radius = circles_[connection.other_circle_name_].radius_;
-      float d_direction = 6/(distance - other_circle_radius - arrow_length);
-
-      QPoint arrow_vertex_0 = circle.second.getRelativeCoordinate(distance - other_circle_radius - arrow_length, direction + d_direction);
-      QPoint arrow_vertex_1 = circle.second.getRelativeCoordinate(distance - other_circle_radius - arrow_length, direction - d_direction);
-      QPoint arrow_vertex_2 = circle.second.getRelativeCoordinate(distance - other_circle_radius, direction);
-
-      QPolygon arrow_head;
-      arrow_head.clear();
-      arrow_head << arrow_vertex_0 << arrow_vertex_1 << arrow_vertex_2;
-      painter.setPen(arrow_pen);
-      painter.drawPolygon(arrow_head);
+      drawEdge(painter, getEdgeGeometry(circle.second, circles_.at(connection.other_circle_name_)));
     }
   }
 
   // Draw circle shadows
-  QPen shadow_pen;
-  shadow_pen.setStyle(Qt::PenStyle::NoPen);
-  painter.setPen(shadow_pen);
-  painter.setBrush(Qt::darkGray);
-
   for (const auto& circle : circles_)
   {
-    painter.drawEllipse(circle.second.x_ - circle.second.radius_ + 2
-    , circle.second.y_ - circle.second.radius_ + 2
-    , circle.second.radius_*2
-    , circle.second.radius_*2);
+    if (circle.first != dragged_circle_)
+    {
+      drawCircleShadow(painter, circle.second);
+    }
   }
 
   // Draw the circles
-  painter.setBrush(Qt::lightGray);
-  QPen text_pen(Qt::black, 1);
   for (const auto& circle : circles_)
   {
-    QPen body_pen;
-    if (circle.second.name_ == selected_circle_)
+    if (circle.first != dragged_circle_)
     {
-      body_pen = QPen(circle.second.border_color_, circle.second.border_width_);
+      drawCircle(painter, circle.second);
     }
-    else
+  }
+
+  static_layer_dirty_ = false;
+}
+
+void UmrfGraphWidget::drawEdge(QPainter& painter, const EdgeGeometry& edge) const
+{
+  painter.setPen(QPen(Qt::darkGray, 2));
+  painter.setBrush(Qt::darkGray);
+  painter.drawLine(edge.line_);
+
+  painter.setPen(Qt::NoPen);
+  painter.drawPolygon(edge.arrow_head_);
+}
+
+void UmrfGraphWidget::drawCircleShadow(QPainter& painter, const CircleHelper& circle) const
+{
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(Qt::darkGray);
+  painter.drawEllipse(circle.x_ - circle.radius_ + 2
+  , circle.y_ - circle.radius_ + 2
+  , circle.radius_*2
+  , circle.radius_*2);
+}
+
+void UmrfGraphWidget::drawCircle(QPainter& painter, const CircleHelper& circle) const
+{
+  QPen body_pen;
+  if (circle.name_ == selected_circle_)
+  {
+    body_pen = QPen(circle.border_color_, circle.border_width_);
+  }
+  else
+  {
+    body_pen.setStyle(Qt::PenStyle::NoPen);
+  }
+  painter.setPen(body_pen);
+  painter.setBrush(Qt::lightGray);
+
+  painter.drawEllipse(circle.x_ - circle.radius_
+  , circle.y_ - circle.radius_
+  , circle.radius_*2
+  , circle.radius_*2);
+
+  // Draw the texts
+  painter.setPen(QPen(Qt::black, 1));
+  painter.setFont(label_font_);
+  painter.drawText(circle.x_ + 25, circle.y_ - 14, getCircleLabel(circle));
+
+  painter.setFont(description_font_);
+  painter.drawText(circle.x_ + 30, circle.y_ - 2, QString(circle.umrf_->getDescription().c_str()));
+}
+
+const EdgeGeometry& UmrfGraphWidget::getEdgeGeometry(const CircleHelper& circle, const CircleHelper& other_circle)
+{
+  EdgeGeometry& edge = edge_geometries_[std::make_pair(circle.name_, other_circle.name_)];
+
+  // The geometry is valid until either end of the connection moves
+  if (!edge.arrow_head_.isEmpty()
+  && edge.line_.p1() == circle.posAsQpoint()
+  && edge.line_.p2() == other_circle.posAsQpoint())
+  {
+    return edge;
+  }
+
+  // Build the arrow head
+  float direction = circle.getRelativeDirection(other_circle);
+  float distance = circle.getRelativeDistance(other_circle);
+  float arrow_length = 14;
+  float other_circle_radius = other_circle.radius_;
+  float d_direction = 6/(distance - other_circle_radius - arrow_length);
+
+  edge.line_ = QLine(circle.posAsQpoint(), other_circle.posAsQpoint());
+  edge.arrow_head_.clear();
+  edge.arrow_head_ << circle.getRelativeCoordinate(distance - other_circle_radius - arrow_length, direction + d_direction)
+    << circle.getRelativeCoordinate(distance - other_circle_radius - arrow_length, direction - d_direction)
+    << circle.getRelativeCoordinate(distance - other_circle_radius, direction);
+
+  edge.bounds_ = QRect(edge.line_.p1(), edge.line_.p2()).normalized()
+    .united(edge.arrow_head_.boundingRect())
+    .adjusted(-PAINT_MARGIN, -PAINT_MARGIN, PAINT_MARGIN, PAINT_MARGIN);
+  return edge;
+}
+
+QRect UmrfGraphWidget::getCircleBounds(const CircleHelper& circle) const
+{
+  // The body together with the shadow
+  QRect bounds(circle.x_ - circle.radius_
+  , circle.y_ - circle.radius_
+  , circle.radius_*2 + 2
+  , circle.radius_*2 + 2);
+
+  // The texts, the bounding rectangles are relative to the baseline
+  bounds |= QFontMetrics(label_font_).boundingRect(getCircleLabel(circle))
+    .translated(circle.x_ + 25, circle.y_ - 14);
+  bounds |= QFontMetrics(description_font_).boundingRect(QString(circle.umrf_->getDescription().c_str()))
+    .translated(circle.x_ + 30, circle.y_ - 2);
+
+  return bounds.adjusted(-PAINT_MARGIN, -PAINT_MARGIN, PAINT_MARGIN, PAINT_MARGIN);
+}
+
+QRegion UmrfGraphWidget::getDraggedRegion()
+{
+  QRegion region(getCircleBounds(circles_.at(dragged_circle_)));
+  for (const auto& edge : dragged_edges_)
+  {
+    region += getEdgeGeometry(circles_.at(edge.first), circles_.at(edge.second)).bounds_;
+  }
+  return region;
+}
+
+void UmrfGraphWidget::startDrag(const std::string& circle_name)
+{
+  dragged_circle_ = circle_name;
+
+  // Collect the connections that move along with the circle
+  dragged_edges_.clear();
+  for (const auto& circle : circles_)
+  {
+    for (const auto& connection : circle.second.connections_)
     {
-      body_pen.setStyle(Qt::PenStyle::NoPen);
+      if (connection.direction_ == CircleHelper::ConnectionHelper::Direction::OUTBOUND
+      && (circle.first == circle_name || connection.other_circle_name_ == circle_name)
+      && circles_.find(connection.other_circle_name_) != circles_.end())
+      {
+        dragged_edges_.emplace_back(circle.first, connection.other_circle_name_);
+      }
     }
-    painter.setPen(body_pen);
-    
-    painter.drawEllipse(circle.second.x_ - circle.second.radius_
-    , circle.second.y_ - circle.second.radius_
-    , circle.second.radius_*2
-    , circle.second.radius_*2);
+  }
 
-    // Draw the texts
-    painter.setPen(text_pen);
-    QFont font;
-    font.setPixelSize(12);
-    painter.setFont(font);
-    std::string name = circle.second.getUmrfName() + " " + std::to_string(circle.second.umrf_->getSuffix());
-    painter.drawText(circle.second.x_ + 25, circle.second.y_ - 14, QString(name.c_str()));
+  // Take the dragged circle out of the static layer
+  redrawGraph();
+}
 
-    font.setPixelSize(9);
-    painter.setFont(font);
-    painter.drawText(circle.second.x_ + 30, circle.second.y_ - 2, QString(circle.second.umrf_->getDescription().c_str()));
-  }
+void UmrfGraphWidget::stopDrag()
+{
+  dragged_circle_.clear();
+  dragged_edges_.clear();
+  redrawGraph();
+}
+
+void UmrfGraphWidget::redrawGraph()
+{
+  static_layer_dirty_ = true;
+  update();
 }
 
 void UmrfGraphWidget::paintEvent(QPaintEvent* pe)
 {
-  drawGraph();
+  if (static_layer_dirty_ || static_layer_.size() != size() * devicePixelRatioF())
+  {
+    renderStaticLayer();
+  }
+
+  // Copy only the parts of the static layer that need repainting
+  QPainter painter(this);
+  const qreal pixel_ratio = static_layer_.devicePixelRatio();
+  for (const QRect& rect : pe->region())
+  {
+    painter.drawPixmap(rect, static_layer_, QRectF(rect.x() * pixel_ratio
+    , rect.y() * pixel_ratio
+    , rect.width() * pixel_ratio
+    , rect.height() * pixel_ratio));
+  }
+
+  // The dragged circle and its connections are drawn on top of the static layer
+  if (!dragged_circle_.empty())
+  {
+    painter.setRenderHint(QPainter::Antialiasing,true);
+    for (const auto& edge : dragged_edges_)
+    {
+      drawEdge(painter, getEdgeGeometry(circles_.at(edge.first), circles_.at(edge.second)));
+    }
+    drawCircleShadow(painter, circles_.at(dragged_circle_));
+    drawCircle(painter, circles_.at(dragged_circle_));
+  }
 }
 
 void UmrfGraphWidget::refreshGraph()
@@ -204,7 +362,7 @@ void UmrfGraphWidget::refreshGraph()
   }
 
   // Redraw the graph
-  update();
+  redrawGraph();
 }
 
 void UmrfGraphWidget::mousePressEvent(QMouseEvent* event)
@@ -215,21 +373,14 @@ void UmrfGraphWidget::mousePressEvent(QMouseEvent* event)
   clicked_circle_name_ = "";
 
   // Check if any circles were clicked
-  for (auto& circle : circles_)
-  {
-    if (circle.second.isInCircle(event->x(), event->y()))
-    {
-      clicked_circle_name_ = circle.first;
-      break;  
-    }
-  }
+  clicked_circle_name_ = circle_grid_.findCircleAt(event->x(), event->y());
 
   // If a circle was clicked with left button then select the circle
   if (!clicked_circle_name_.empty() && event->button() == Qt::LeftButton)
   {
     setNewSelectedCircle(clicked_circle_name_);
     circle_dropped_ = false;
-    update();
+    startDrag(clicked_circle_name_);
     return;
   }
   // If empty space was left-clicked, then unselect the selected cirlcle
@@ -240,7 +391,7 @@ void UmrfGraphWidget::mousePressEvent(QMouseEvent* event)
       circles_[selected_circle_].unSelect();
       selected_circle_ = "";
     }
-    update();
+    redrawGraph();
     Q_EMIT noUmrfSelected();
     return;
   }
@@ -292,46 +443,28 @@ void UmrfGraphWidget::mousePressEvent(QMouseEvent* event)
 
 void UmrfGraphWidget::mouseReleaseEvent(QMouseEvent *event)
 {
+  const bool circle_was_dragged = !circle_dropped_ && !selected_circle_.empty();
   circle_dropped_ = true;
 
-  // Push the circles that are in collision apart from each oter
-  for (const auto& first_circle : circles_)
+  // Push the circles that the dropped circle collides with out of the way
+  if (circle_was_dragged)
   {
-    for (auto& second_circle : circles_)
-    {
-      // Ignore itself
-      if (first_circle.first == second_circle.first)
-      {
-        continue;
-      }
-
-      int overlap = first_circle.second.isInCollisionWith(second_circle.second);
-
-      // Ignore non-colliding circles
-      if (overlap == 0)
-      {
-        continue;
-      }
-
-      float direction = first_circle.second.getRelativeDirection(second_circle.second);
-      int x_overlap = (overlap + 10) * std::cos(direction);
-      int y_overlap = (overlap + 10) * std::sin(direction);
-      second_circle.second.x_ -= x_overlap;
-      second_circle.second.y_ -= y_overlap; 
-    }
+    resolveOverlaps({selected_circle_}, true);
   }
-  update();
+  stopDrag();
 }
 
 void UmrfGraphWidget::mouseMoveEvent(QMouseEvent* event)
 {
   if (!circle_dropped_ 
   && isInBounds(canvas_width_, canvas_height_, event->x(), event->y())
-  && !selected_circle_.empty())
+  && !dragged_circle_.empty())
   {
-    circles_[selected_circle_].x_ = event->x();
-    circles_[selected_circle_].y_ = event->y();
-    update();
+    // Repaint only where the circle and its connections were and where they are now
+    QRegion dirty_region = getDraggedRegion();
+    moveCircle(dragged_circle_, event->x(), event->y());
+    dirty_region += getDraggedRegion();
+    update(dirty_region);
   }
 }
 
@@ -358,23 +491,23 @@ void UmrfGraphWidget::setNewSelectedCircle(const std::string& new_selected_circl
 void UmrfGraphWidget::addCircle()
 {
   std::string unique_circle_name = getUniqueCircleName();
-  circles_.insert({unique_circle_name, CircleHelper(unique_circle_name, clicked_point_x_, clicked_point_y_, 25)});
+  insertCircle(CircleHelper(unique_circle_name, clicked_point_x_, clicked_point_y_, 25));
   umrfs_.push_back(circles_[unique_circle_name].umrf_);
 
   setNewSelectedCircle(unique_circle_name);
-  update();
+  redrawGraph();
 }
 
 void UmrfGraphWidget::addNamedCircle(QAction *action)
 {
   std::string unique_circle_name = getUniqueCircleName();
-  circles_.insert({unique_circle_name, CircleHelper(unique_circle_name, clicked_point_x_, clicked_point_y_, 25)});
+  insertCircle(CircleHelper(unique_circle_name, clicked_point_x_, clicked_point_y_, 25));
   circles_[unique_circle_name].umrf_ = std::make_shared<UmrfNode>(action_indexer_->getUmrf(action->text().toStdString()));
   circles_[unique_circle_name].umrf_->setName(circles_[unique_circle_name].umrf_->getPackageName());
   umrfs_.push_back(circles_[unique_circle_name].umrf_);
 
   setNewSelectedCircle(unique_circle_name);
-  update();
+  redrawGraph();
 }
 
 void UmrfGraphWidget::connectCircles()
@@ -382,7 +515,7 @@ void UmrfGraphWidget::connectCircles()
   circles_[selected_circle_].connectWith(circles_[clicked_circle_name_]);
   circles_[selected_circle_].umrf_->addChild(circles_[clicked_circle_name_].umrf_->asRelation());
   circles_[clicked_circle_name_].umrf_->addParent(circles_[selected_circle_].umrf_->asRelation());
-  update();
+  redrawGraph();
 }
 
 void UmrfGraphWidget::disconnectCircles()
@@ -390,7 +523,8 @@ void UmrfGraphWidget::disconnectCircles()
   circles_[selected_circle_].disconnectWith(circles_[clicked_circle_name_]);
   circles_[selected_circle_].umrf_->removeChild(circles_[clicked_circle_name_].umrf_->asRelation());
   circles_[clicked_circle_name_].umrf_->removeParent(circles_[selected_circle_].umrf_->asRelation());
-  update();
+  edge_geometries_.erase(std::make_pair(selected_circle_, clicked_circle_name_));
+  redrawGraph();
 }
 
 void UmrfGraphWidget::removeCircle()
@@ -425,6 +559,8 @@ void UmrfGraphWidget::removeCircle()
 
   // Erase the circle
   circles_.erase(clicked_circle_name_);
+  circle_grid_.remove(clicked_circle_name_);
+  edge_geometries_.clear();
   if (clicked_circle_name_ == selected_circle_)
   {
     selected_circle_ = "";
@@ -478,11 +614,11 @@ void UmrfGraphWidget::addUmrf(const UmrfNode& umrf)
   }
 
   local_umrf.setSuffix(getDuplicateUmrfs(local_umrf.getName()).size());
-  circles_.insert({unique_circle_name, CircleHelper(std::make_shared<UmrfNode>(local_umrf), unique_circle_name, 100, max_y_pos, 25)});
+  insertCircle(CircleHelper(std::make_shared<UmrfNode>(local_umrf), unique_circle_name, 100, max_y_pos, 25));
   umrfs_.push_back(circles_[unique_circle_name].umrf_);
  
   setNewSelectedCircle(unique_circle_name);
-  update();
+  redrawGraph();
 }
 
 std::string UmrfGraphWidget::getUniqueCircleName()
@@ -490,6 +626,36 @@ std::string UmrfGraphWidget::getUniqueCircleName()
   return "action_" + std::to_string(circle_uniqueness_counter_++);
 }
 
+void UmrfGraphWidget::insertCircle(const CircleHelper& circle)
+{
+  circles_.insert({circle.name_, circle});
+  circle_grid_.insert(circle.name_, circle.x_, circle.y_, circle.radius_);
+}
+
+void UmrfGraphWidget::moveCircle(const std::string& circle_name, int x, int y)
+{
+  CircleHelper& circle = circles_.at(circle_name);
+  circle.x_ = x;
+  circle.y_ = y;
+  circle_grid_.move(circle_name, x, y);
+}
+
+void UmrfGraphWidget::resolveOverlaps(const std::vector<std::string>& seed_circles, bool pin_seeds)
+{
+  std::vector<std::string> moved_circles;
+  if (!circle_grid_.resolveOverlaps(seed_circles, pin_seeds, CIRCLE_SPACING, MAX_OVERLAP_PASSES, moved_circles))
+  {
+    std::cout << "Some of the circles still overlap after " << MAX_OVERLAP_PASSES << " passes" << std::endl;
+  }
+
+  // Copy the resolved positions back to the circles
+  for (const auto& circle_name : moved_circles)
+  {
+    CircleHelper& circle = circles_.at(circle_name);
+    circle_grid_.getPosition(circle_name, circle.x_, circle.y_);
+  }
+}
+
 std::vector<std::shared_ptr<UmrfNode>> UmrfGraphWidget::getDuplicateUmrfs(const std::string& umrf_name)
 {
   std::vector<std::shared_ptr<UmrfNode>> duplicate_umrfs;
@@ -553,9 +719,7 @@ bool CircleHelper::isInCircle(int x_in, int y_in) const
 {
   int x_diff = x_ - x_in;
   int y_diff = y_ - y_in;
-  int diff_length = std::sqrt(std::pow(x_diff, 2) + std::pow(y_diff, 2));
-
-  return diff_length <= radius_;
+  return x_diff * x_diff + y_diff * y_diff <= radius_ * radius_;
 }
 
 int CircleHelper::isInCollisionWith(const CircleHelper& other_circle) const
@@ -0,0 +1,137 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/action_manifest.h"
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <stdexcept>
+
+using temoto_action_assistant::ActionManifestEntry;
+using temoto_action_assistant::ActionManifestParameter;
+using temoto_action_assistant::decodeActionManifest;
+using temoto_action_assistant::encodeActionManifest;
+
+namespace
+{
+ActionManifestEntry makeEntry(const std::string& package_name, const std::string& class_name)
+{
+  ActionManifestEntry entry;
+  entry.package_name = package_name;
+  entry.class_name = class_name;
+  entry.library_path = "lib/lib" + package_name + ".so";
+  entry.umrf_path = package_name + "/umrf.json";
+  entry.umrf_json = "{\"name\": \"" + class_name + "\"}";
+  entry.umrf_hash = temoto_action_assistant::hashUmrfJson(entry.umrf_json);
+  entry.parameters.push_back(ActionManifestParameter{"pose::x", "number", true});
+  entry.parameters.push_back(ActionManifestParameter{"result", "string", false});
+  return entry;
+}
+
+void expectEqual(const ActionManifestEntry& expected, const ActionManifestEntry& actual)
+{
+  EXPECT_EQ(expected.package_name, actual.package_name);
+  EXPECT_EQ(expected.class_name, actual.class_name);
+  EXPECT_EQ(expected.library_path, actual.library_path);
+  EXPECT_EQ(expected.umrf_path, actual.umrf_path);
+  EXPECT_EQ(expected.umrf_hash, actual.umrf_hash);
+  EXPECT_EQ(expected.umrf_json, actual.umrf_json);
+  ASSERT_EQ(expected.parameters.size(), actual.parameters.size());
+  for (std::size_t i = 0; i < expected.parameters.size(); i++)
+  {
+    EXPECT_EQ(expected.parameters[i].name, actual.parameters[i].name);
+    EXPECT_EQ(expected.parameters[i].type, actual.parameters[i].type);
+    EXPECT_EQ(expected.parameters[i].input, actual.parameters[i].input);
+  }
+}
+} // anonymous namespace
+
+TEST(ActionManifest, HashesWithFnv1a)
+{
+  EXPECT_EQ(temoto_action_assistant::hashUmrfJson(""), 14695981039346656037ULL);
+  EXPECT_EQ(temoto_action_assistant::hashUmrfJson("a"), 0xaf63dc4c8601ec8cULL);
+}
+
+TEST(ActionManifest, RoundTripsEntries)
+{
+  const std::vector<ActionManifestEntry> entries = {makeEntry("ta_first", "TaFirst"), makeEntry("ta_second", "TaSecond")};
+  const std::string encoded = encodeActionManifest(entries);
+  EXPECT_EQ(encoded.substr(0, 4), "TAMF");
+
+  const std::vector<ActionManifestEntry> decoded = decodeActionManifest(encoded.data(), encoded.size());
+  ASSERT_EQ(decoded.size(), entries.size());
+  for (std::size_t i = 0; i < entries.size(); i++)
+  {
+    expectEqual(entries[i], decoded[i]);
+  }
+
+  const std::string empty = encodeActionManifest({});
+  EXPECT_TRUE(decodeActionManifest(empty.data(), empty.size()).empty());
+}
+
+TEST(ActionManifest, RejectsInvalidData)
+{
+  const std::string encoded = encodeActionManifest({makeEntry("ta_test", "TaTest")});
+
+  std::string wrong_tag = encoded;
+  wrong_tag[0] = 'X';
+  EXPECT_THROW(decodeActionManifest(wrong_tag.data(), wrong_tag.size()), std::runtime_error);
+
+  std::string wrong_version = encoded;
+  wrong_version[4] = static_cast<char>(wrong_version[4] + 1);
+  EXPECT_THROW(decodeActionManifest(wrong_version.data(), wrong_version.size()), std::runtime_error);
+
+  for (std::size_t size = 0; size < encoded.size(); size++)
+  {
+    EXPECT_THROW(decodeActionManifest(encoded.data(), size), std::runtime_error) << "truncated to " << size;
+  }
+
+  const std::string trailing_data = encoded + "x";
+  EXPECT_THROW(decodeActionManifest(trailing_data.data(), trailing_data.size()), std::runtime_error);
+}
+
+TEST(ActionManifest, UpdatesAndMapsTheManifest)
+{
+  const boost::filesystem::path actions_path = boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("action_manifest_test_%%%%%%%%");
+
+  temoto_action_assistant::MappedActionManifest manifest(actions_path.string());
+  EXPECT_FALSE(manifest.refresh());
+  EXPECT_FALSE(manifest.exists());
+
+  temoto_action_assistant::writeActionManifest(actions_path.string(), {makeEntry("ta_first", "TaFirst")});
+  EXPECT_TRUE(manifest.refresh());
+  ASSERT_TRUE(manifest.exists());
+  EXPECT_EQ(manifest.getEntries().size(), 1u);
+  EXPECT_FALSE(manifest.refresh());
+
+  // Entries of the same library are replaced, the others are kept
+  ActionManifestEntry regenerated = makeEntry("ta_first", "TaFirst");
+  regenerated.umrf_json = "{}";
+  temoto_action_assistant::updateActionManifest(actions_path.string(), {regenerated, makeEntry("ta_second", "TaSecond")});
+  EXPECT_TRUE(manifest.refresh());
+  const std::vector<ActionManifestEntry> entries = manifest.getEntries();
+  boost::filesystem::remove_all(actions_path);
+
+  ASSERT_EQ(entries.size(), 2u);
+  expectEqual(regenerated, entries[0]);
+  expectEqual(makeEntry("ta_second", "TaSecond"), entries[1]);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/widgets/circle_grid.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+
+using temoto_action_assistant::CircleGrid;
+
+namespace
+{
+/*
+ * Returns the names of the circle pairs that overlap, checked by brute force
+ */
+std::vector<std::string> findOverlaps(const CircleGrid& grid, const std::vector<std::string>& names, int radius)
+{
+  std::vector<std::string> overlaps;
+  for (std::size_t i = 0; i < names.size(); i++)
+  {
+    for (std::size_t j = i + 1; j < names.size(); j++)
+    {
+      int x_i, y_i, x_j, y_j;
+      grid.getPosition(names[i], x_i, y_i);
+      grid.getPosition(names[j], x_j, y_j);
+      const std::int64_t x_diff = x_i - x_j;
+      const std::int64_t y_diff = y_i - y_j;
+      if (x_diff * x_diff + y_diff * y_diff < std::int64_t(2 * radius) * (2 * radius))
+      {
+        overlaps.push_back(names[i] + "/" + names[j]);
+      }
+    }
+  }
+  return overlaps;
+}
+} // anonymous namespace
+
+TEST(CircleGrid, FindsCirclesAtPoints)
+{
+  CircleGrid grid(100);
+  grid.insert("a", 50, 50, 30);
+  grid.insert("b", -150, 20, 30);
+
+  EXPECT_EQ(grid.findCircleAt(50, 50), "a");
+  EXPECT_EQ(grid.findCircleAt(79, 50), "a");
+  EXPECT_EQ(grid.findCircleAt(81, 50), "");
+  EXPECT_EQ(grid.findCircleAt(-170, 10), "b");
+
+  // The smallest name wins if the circles overlap
+  grid.insert("0", 60, 50, 30);
+  EXPECT_EQ(grid.findCircleAt(55, 50), "0");
+}
+
+TEST(CircleGrid, MovesAndRemovesCircles)
+{
+  CircleGrid grid(100);
+  grid.insert("a", 50, 50, 30);
+  grid.move("a", 450, 450);
+
+  EXPECT_EQ(grid.findCircleAt(50, 50), "");
+  EXPECT_EQ(grid.findCircleAt(450, 450), "a");
+  int x, y;
+  ASSERT_TRUE(grid.getPosition("a", x, y));
+  EXPECT_EQ(x, 450);
+  EXPECT_EQ(y, 450);
+
+  // Inserting an existing name moves it
+  grid.insert("a", -50, -50, 30);
+  EXPECT_EQ(grid.size(), 1u);
+  EXPECT_EQ(grid.findCircleAt(-50, -50), "a");
+
+  grid.remove("a");
+  EXPECT_EQ(grid.size(), 0u);
+  EXPECT_EQ(grid.findCircleAt(-50, -50), "");
+  EXPECT_FALSE(grid.getPosition("a", x, y));
+}
+
+TEST(CircleGrid, FindsCirclesInRectangles)
+{
+  CircleGrid grid(50);
+  grid.insert("inside", 10, 10, 20);
+  grid.insert("edge", 100, 100, 20);
+  grid.insert("outside", 101, 50, 20);
+
+  // The corners can be given in any order
+  std::vector<std::string> names = grid.findCirclesInRect(100, 100, 0, 0);
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, (std::vector<std::string>{"edge", "inside"}));
+}
+
+TEST(CircleGrid, ResolvesOverlaps)
+{
+  const int radius = 20;
+  CircleGrid grid(2 * radius);
+  std::vector<std::string> names;
+  for (int i = 0; i < 10; i++)
+  {
+    names.push_back("c" + std::to_string(i));
+    grid.insert(names.back(), (i % 3) * 10, (i / 3) * 10, radius);
+  }
+
+  std::vector<std::string> moved_names;
+  EXPECT_TRUE(grid.resolveOverlaps(names, false, 0, 1000, moved_names));
+  EXPECT_TRUE(findOverlaps(grid, names, radius).empty());
+  EXPECT_FALSE(moved_names.empty());
+}
+
+TEST(CircleGrid, KeepsPinnedSeedsInPlace)
+{
+  CircleGrid grid(50);
+  grid.insert("dropped", 0, 0, 20);
+  grid.insert("other", 5, 0, 20);
+
+  std::vector<std::string> moved_names;
+  EXPECT_TRUE(grid.resolveOverlaps({"dropped"}, true, 4, 100, moved_names));
+  EXPECT_EQ(moved_names, std::vector<std::string>{"other"});
+
+  int x, y;
+  grid.getPosition("dropped", x, y);
+  EXPECT_EQ(x, 0);
+  EXPECT_EQ(y, 0);
+  grid.getPosition("other", x, y);
+  EXPECT_GE(x, 44);
+  EXPECT_EQ(y, 0);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/output_sink.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using temoto_action_assistant::MemorySink;
+using temoto_action_assistant::OutputSink;
+using temoto_action_assistant::TarSink;
+
+namespace
+{
+const std::size_t BLOCK_SIZE = 512;
+
+std::string readField(const std::string& archive, std::size_t offset, std::size_t size)
+{
+  const std::string field = archive.substr(offset, size);
+  return field.substr(0, field.find('\0'));
+}
+
+std::size_t readOctal(const std::string& archive, std::size_t offset, std::size_t size)
+{
+  return std::strtoul(readField(archive, offset, size).c_str(), nullptr, 8);
+}
+
+unsigned int computeChecksum(const std::string& archive, std::size_t header_offset)
+{
+  unsigned int checksum = 0;
+  for (std::size_t i = 0; i < BLOCK_SIZE; i++)
+  {
+    const bool checksum_field = i >= 148 && i < 156;
+    checksum += checksum_field ? ' ' : static_cast<unsigned char>(archive[header_offset + i]);
+  }
+  return checksum;
+}
+} // anonymous namespace
+
+TEST(TarSink, WritesUstarEntries)
+{
+  std::stringstream archive_stream;
+  {
+    TarSink sink(archive_stream);
+    sink.createDirectory("ta_test/src");
+    sink.writeFile("ta_test/src/ta_test.cpp", "int main() {}\n");
+  }
+  const std::string archive = archive_stream.str();
+
+  // Two directory headers, a file header with one block of content and the end marker
+  ASSERT_EQ(archive.size(), 6 * BLOCK_SIZE);
+
+  EXPECT_EQ(readField(archive, 0, 100), "ta_test/");
+  EXPECT_EQ(archive[156], '5');
+  EXPECT_EQ(readField(archive, BLOCK_SIZE, 100), "ta_test/src/");
+
+  const std::size_t file_header = 2 * BLOCK_SIZE;
+  EXPECT_EQ(readField(archive, file_header, 100), "ta_test/src/ta_test.cpp");
+  EXPECT_EQ(archive[file_header + 156], '0');
+  EXPECT_EQ(readField(archive, file_header + 257, 6), "ustar");
+  EXPECT_EQ(readOctal(archive, file_header + 124, 12), 14u);
+  EXPECT_EQ(readOctal(archive, file_header + 148, 8), computeChecksum(archive, file_header));
+  EXPECT_EQ(archive.substr(file_header + BLOCK_SIZE, 14), "int main() {}\n");
+
+  EXPECT_EQ(archive.substr(4 * BLOCK_SIZE), std::string(2 * BLOCK_SIZE, '\0'));
+}
+
+TEST(TarSink, BuffersFilesOfUnknownSize)
+{
+  std::stringstream known_size_stream;
+  std::stringstream unknown_size_stream;
+  {
+    TarSink known_size_sink(known_size_stream);
+    known_size_sink.writeFile("file.txt", "content");
+
+    TarSink unknown_size_sink(unknown_size_stream);
+    unknown_size_sink.beginFile("file.txt", OutputSink::UNKNOWN_SIZE) << "con" << "tent";
+    unknown_size_sink.endFile();
+  }
+
+  // The headers differ only in the modification time
+  const std::string known_size_archive = known_size_stream.str();
+  const std::string unknown_size_archive = unknown_size_stream.str();
+  ASSERT_EQ(known_size_archive.size(), unknown_size_archive.size());
+  EXPECT_EQ(readOctal(unknown_size_archive, 124, 12), 7u);
+  EXPECT_EQ(known_size_archive.substr(BLOCK_SIZE), unknown_size_archive.substr(BLOCK_SIZE));
+}
+
+TEST(TarSink, SplitsLongPaths)
+{
+  const std::string directory(60, 'd');
+  const std::string name = std::string(70, 'n') + ".txt";
+
+  std::stringstream archive_stream;
+  TarSink sink(archive_stream);
+  sink.writeFile(directory + "/" + name, "x");
+  sink.finish();
+  const std::string archive = archive_stream.str();
+
+  EXPECT_EQ(readField(archive, 0, 100), name);
+  EXPECT_EQ(readField(archive, 345, 155), directory);
+}
+
+TEST(TarSink, RejectsSizeMismatches)
+{
+  std::stringstream archive_stream;
+  TarSink sink(archive_stream);
+  sink.beginFile("file.txt", 10) << "short";
+  EXPECT_THROW(sink.endFile(), std::runtime_error);
+}
+
+TEST(TarSink, RejectsFilesAfterFinish)
+{
+  std::stringstream archive_stream;
+  TarSink sink(archive_stream);
+  sink.finish();
+  EXPECT_THROW(sink.writeFile("file.txt", "x"), std::runtime_error);
+}
+
+TEST(MemorySink, KeepsFilesAndDirectories)
+{
+  MemorySink sink;
+  sink.createDirectory("ta_test/include/ta_test");
+  sink.writeFile("ta_test//./CMakeLists.txt", "project(ta_test)\n");
+  sink.beginFile("ta_test/package.xml", OutputSink::UNKNOWN_SIZE) << "<package>" << "</package>";
+  sink.endFile();
+
+  EXPECT_EQ(sink.getDirectories().count("ta_test"), 1u);
+  EXPECT_EQ(sink.getDirectories().count("ta_test/include/ta_test"), 1u);
+
+  ASSERT_NE(sink.findFile("ta_test/CMakeLists.txt"), nullptr);
+  EXPECT_EQ(*sink.findFile("ta_test/CMakeLists.txt"), "project(ta_test)\n");
+  ASSERT_NE(sink.findFile("ta_test/package.xml"), nullptr);
+  EXPECT_EQ(*sink.findFile("ta_test/package.xml"), "<package></package>");
+  EXPECT_EQ(sink.findFile("ta_test/missing.txt"), nullptr);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
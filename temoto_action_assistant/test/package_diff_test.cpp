@@ -0,0 +1,117 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/package_diff.h"
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using temoto_action_assistant::FileChange;
+using temoto_action_assistant::MemorySink;
+using temoto_action_assistant::makeUnifiedDiff;
+
+TEST(UnifiedDiff, IsEmptyForEqualContents)
+{
+  EXPECT_EQ(makeUnifiedDiff("a\nb\n", "a\nb\n", "old", "new"), "");
+  EXPECT_EQ(makeUnifiedDiff("", "", "old", "new"), "");
+}
+
+TEST(UnifiedDiff, ShowsReplacedLines)
+{
+  EXPECT_EQ(makeUnifiedDiff("a\nb\nc\n", "a\nx\nc\n", "old", "new"),
+    "--- old\n"
+    "+++ new\n"
+    "@@ -1,3 +1,3 @@\n"
+    " a\n"
+    "-b\n"
+    "+x\n"
+    " c\n");
+}
+
+TEST(UnifiedDiff, ShowsAddedFiles)
+{
+  EXPECT_EQ(makeUnifiedDiff("", "a\nb\n", "old", "new"),
+    "--- old\n"
+    "+++ new\n"
+    "@@ -0,0 +1,2 @@\n"
+    "+a\n"
+    "+b\n");
+}
+
+TEST(UnifiedDiff, LimitsTheContext)
+{
+  const std::string old_content = "1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n";
+  const std::string new_content = "1\n2\n3\n4\n5\nX\n7\n8\n9\n10\n";
+  EXPECT_EQ(makeUnifiedDiff(old_content, new_content, "o", "n", 1),
+    "--- o\n"
+    "+++ n\n"
+    "@@ -5,3 +5,3 @@\n"
+    " 5\n"
+    "-6\n"
+    "+X\n"
+    " 7\n");
+}
+
+TEST(UnifiedDiff, SeparatesDistantChanges)
+{
+  const std::string old_content = "a\n1\n2\n3\n4\n5\n6\n7\n8\nb\n";
+  const std::string new_content = "A\n1\n2\n3\n4\n5\n6\n7\n8\nB\n";
+  const std::string diff = makeUnifiedDiff(old_content, new_content, "o", "n", 2);
+  EXPECT_NE(diff.find("@@ -1,3 +1,3 @@\n-a\n+A\n 1\n 2\n"), std::string::npos);
+  EXPECT_NE(diff.find("@@ -8,3 +8,3 @@\n 7\n 8\n-b\n+B\n"), std::string::npos);
+}
+
+TEST(UnifiedDiff, MarksMissingNewlineAtEndOfFile)
+{
+  EXPECT_EQ(makeUnifiedDiff("a\nb", "a\nb\n", "o", "n"),
+    "--- o\n"
+    "+++ n\n"
+    "@@ -1,2 +1,2 @@\n"
+    " a\n"
+    "-b\n"
+    "\\ No newline at end of file\n"
+    "+b\n");
+}
+
+TEST(DiffAgainstDisk, ReportsAddedAndModifiedFiles)
+{
+  const boost::filesystem::path base_path = boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("package_diff_test_%%%%%%%%");
+  boost::filesystem::create_directories(base_path / "ta_test");
+  std::ofstream((base_path / "ta_test/same.txt").string()) << "same\n";
+  std::ofstream((base_path / "ta_test/changed.txt").string()) << "old\n";
+
+  MemorySink sink;
+  sink.writeFile("ta_test/same.txt", "same\n");
+  sink.writeFile("ta_test/changed.txt", "new\n");
+  sink.writeFile("ta_test/added.txt", "added\n");
+
+  const std::vector<FileChange> changes = temoto_action_assistant::diffAgainstDisk(sink, base_path.string());
+  boost::filesystem::remove_all(base_path);
+
+  ASSERT_EQ(changes.size(), 2u);
+  EXPECT_EQ(changes[0].path, "ta_test/added.txt");
+  EXPECT_EQ(changes[0].type, FileChange::Type::ADDED);
+  EXPECT_EQ(changes[1].path, "ta_test/changed.txt");
+  EXPECT_EQ(changes[1].type, FileChange::Type::MODIFIED);
+  EXPECT_NE(changes[1].diff.find("-old\n+new\n"), std::string::npos);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright 2020 TeMoto Telerobotics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "temoto_action_assistant/template_engine.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+
+using temoto_action_assistant::CompiledTemplate;
+using temoto_action_assistant::TemplateArguments;
+
+TEST(TemplateEngine, SubstitutesArguments)
+{
+  TemplateArguments args;
+  args.set("name", "ta_test");
+  EXPECT_EQ(CompiledTemplate("package $(arg name);").render(args), "package ta_test;");
+}
+
+TEST(TemplateEngine, UsesDefaultsForUnsetArguments)
+{
+  CompiledTemplate compiled_template("$(arg size)", {{"size", "42"}});
+  EXPECT_EQ(compiled_template.render(TemplateArguments()), "42");
+}
+
+TEST(TemplateEngine, KeepsUnknownSubstitutionsVerbatim)
+{
+  // roslaunch substitutions have to pass through
+  const std::string text = "$(arg robot_name) $(find temoto)";
+  EXPECT_EQ(CompiledTemplate(text).render(TemplateArguments()), text);
+}
+
+TEST(TemplateEngine, RendersLoopsWithLoopState)
+{
+  TemplateArguments args;
+  args.addListItem("params").set("name", "a");
+  args.addListItem("params").set("name", "b");
+  args.addListItem("params").set("name", "c");
+
+  CompiledTemplate compiled_template("$(for p in params)$(arg loop.index)=$(arg p.name)$(if !loop.last),$(endif)$(endfor)");
+  EXPECT_EQ(compiled_template.render(args), "0=a,1=b,2=c");
+}
+
+TEST(TemplateEngine, StandaloneDirectivesConsumeTheirLine)
+{
+  TemplateArguments args;
+  args.addListItem("sources").set("path", "src/a.cpp");
+  args.addListItem("sources").set("path", "src/b.cpp");
+
+  CompiledTemplate compiled_template("add_library(\n$(for s in sources)\n  $(arg s.path)\n$(endfor)\n)\n");
+  EXPECT_EQ(compiled_template.render(args), "add_library(\n  src/a.cpp\n  src/b.cpp\n)\n");
+}
+
+TEST(TemplateEngine, EvaluatesConditions)
+{
+  CompiledTemplate compiled_template("$(if tick)tick$(else)blocking$(endif)");
+
+  TemplateArguments args;
+  args.setFlag("tick", true);
+  EXPECT_EQ(compiled_template.render(args), "tick");
+
+  args.setFlag("tick", false);
+  EXPECT_EQ(compiled_template.render(args), "blocking");
+
+  // A list is true if it is not empty
+  CompiledTemplate list_template("$(if items)some$(else)none$(endif)");
+  TemplateArguments list_args;
+  list_args.declareList("items");
+  EXPECT_EQ(list_template.render(list_args), "none");
+  list_args.addListItem("items");
+  EXPECT_EQ(list_template.render(list_args), "some");
+}
+
+TEST(TemplateEngine, RendersDeclaredEmptyListAsNothing)
+{
+  TemplateArguments args;
+  args.declareList("params");
+  EXPECT_EQ(CompiledTemplate("[$(for p in params)$(arg p.name)$(endfor)]").render(args), "[]");
+}
+
+TEST(TemplateEngine, RejectsUnknownLists)
+{
+  TemplateArguments args;
+  args.addListItem("params").set("name", "a");
+  EXPECT_THROW(CompiledTemplate("$(for p in param)$(arg p.name)$(endfor)").render(args), std::runtime_error);
+}
+
+TEST(TemplateEngine, RejectsUnknownLoopVariableFields)
+{
+  TemplateArguments args;
+  args.addListItem("params").set("name", "a");
+  EXPECT_THROW(CompiledTemplate("$(for p in params)$(arg p.nmae)$(endfor)").render(args), std::runtime_error);
+}
+
+TEST(TemplateEngine, RejectsUnterminatedBlocks)
+{
+  EXPECT_THROW(CompiledTemplate("$(for p in params) no end"), std::runtime_error);
+  EXPECT_THROW(CompiledTemplate("$(if flag) no end"), std::runtime_error);
+  EXPECT_THROW(CompiledTemplate("$(endif)"), std::runtime_error);
+}
+
+TEST(TemplateEngine, MeasureMatchesRender)
+{
+  TemplateArguments args;
+  args.set("name", "ta_test");
+  args.addListItem("params").set("name", "a");
+  args.addListItem("params").set("name", "bb");
+
+  CompiledTemplate compiled_template("class $(arg name)\n$(for p in params)\n  $(arg p.name);\n$(endfor)\n");
+  const std::string rendered = compiled_template.render(args);
+  EXPECT_EQ(compiled_template.measure(args), rendered.size());
+
+  std::stringstream ss;
+  compiled_template.render(args, ss);
+  EXPECT_EQ(ss.str(), rendered);
+}
+
+TEST(TemplateEngine, ParsesFileTemplates)
+{
+  const std::string file_template =
+    "<?xml version=\"1.0\" ?>\n"
+    "<f_template extension=\".h\">\n"
+    "  <arg name=\"ta_name\" default=\"err_noname_err\" />\n"
+    "  <body>\n"
+    "<![CDATA[#define $(arg ta_name)_H]]>\n"
+    "  </body>\n"
+    "</f_template>\n";
+
+  const CompiledTemplate compiled_template = CompiledTemplate::fromFileTemplateStr(file_template, "test.xml");
+  EXPECT_EQ(compiled_template.getExtension(), ".h");
+  EXPECT_EQ(compiled_template.getName(), "test.xml");
+  EXPECT_EQ(compiled_template.render(TemplateArguments()), "#define err_noname_err_H");
+
+  EXPECT_THROW(CompiledTemplate::fromFileTemplateStr("<f_template></f_template>", "broken.xml"), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,32 +1,90 @@
-#include "ros/package.h"
-#include "file_template_parser/file_template_parser.h"
+#include "temoto_action_assistant/embedded_templates.h"
 #include <boost/filesystem.hpp>
+#include <fstream>
 #include <iostream>
 
+// Generated from "templates/" at build time
+extern const temoto_action_assistant::EmbeddedTemplateTable WORKSPACE_TEMPLATES;
+
+using temoto_action_assistant::CompiledTemplate;
+using temoto_action_assistant::TemplateArguments;
+
+void saveTemplate(const CompiledTemplate& file_template
+, const TemplateArguments& args
+, const std::string& dst_path
+, const std::string& file_name)
+{
+  std::ofstream file(dst_path + "/" + file_name + file_template.getExtension());
+  file_template.render(args, file);
+}
+
 int main(int argc, char **argv)
 {
   // Check if arguments were provided
-  if (argc != 3)
+  if (argc < 3)
   {
     std::cout << "Invalid number of arguments" << std::endl;
+    std::cout << "Usage: generate_workspace <workspace_name> <path> [--superbuild] [--template_path <dir>]" << std::endl;
     return 1;
   }
 
+  // Optionally build all actions via a single superbuild package
+  bool superbuild = false;
+
+  // Optional directory with templates that override the embedded ones
+  std::string template_override_path;
+
+  for (int i = 3; i < argc; i++)
+  {
+    if (std::string(argv[i]) == "--superbuild")
+    {
+      superbuild = true;
+    }
+    else if (std::string(argv[i]) == "--template_path" && i + 1 < argc)
+    {
+      template_override_path = argv[++i];
+    }
+    else
+    {
+      std::cout << "Unknown argument '" << argv[i] << "'" << std::endl;
+      return 1;
+    }
+  }
+
   // Get the name of the package
   const std::string temoto_ws_name = std::string(argv[1]);
   const std::string temoto_ws_path = std::string(argv[2]) + "/" + temoto_ws_name + "/";
-  const std::string temoto_ws_gen_pkg_path = ros::package::getPath(ROS_PACKAGE_NAME);
   const std::string temoto_ws_package_path = temoto_ws_path + temoto_ws_name + "/";
+  const std::string temoto_ws_superbuild_path = temoto_ws_path + temoto_ws_name + "_actions/";
 
   /*
    * IMPORT THE TEMPLATES
    */ 
-  tp::TemplateContainer t_cmakelists = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_cmakelists.xml");
-  tp::TemplateContainer t_packagexml = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_packagexml.xml");
-  tp::TemplateContainer t_temoto_launch = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_temoto_launch.xml");
-  tp::TemplateContainer t_aa_launch = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_aa_launch.xml");
-  tp::TemplateContainer t_components = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_components.xml");
-  tp::TemplateContainer t_console_conf = tp::TemplateContainer(temoto_ws_gen_pkg_path + "/templates/temoto_ws_console_conf.xml");
+  temoto_action_assistant::TemplateLoader loader(WORKSPACE_TEMPLATES, template_override_path);
+  CompiledTemplate t_cmakelists;
+  CompiledTemplate t_packagexml;
+  CompiledTemplate t_temoto_launch;
+  CompiledTemplate t_aa_launch;
+  CompiledTemplate t_components;
+  CompiledTemplate t_console_conf;
+  CompiledTemplate t_superbuild_cmakelists;
+  CompiledTemplate t_superbuild_packagexml;
+  try
+  {
+    t_cmakelists = loader.load("temoto_ws_cmakelists.xml");
+    t_packagexml = loader.load("temoto_ws_packagexml.xml");
+    t_temoto_launch = loader.load("temoto_ws_temoto_launch.xml");
+    t_aa_launch = loader.load("temoto_ws_aa_launch.xml");
+    t_components = loader.load("temoto_ws_components.xml");
+    t_console_conf = loader.load("temoto_ws_console_conf.xml");
+    t_superbuild_cmakelists = loader.load("temoto_ws_superbuild_cmakelists.xml");
+    t_superbuild_packagexml = loader.load("temoto_ws_superbuild_packagexml.xml");
+  }
+  catch (const std::exception& e)
+  {
+    std::cout << "Could not load the templates: " << e.what() << std::endl;
+    return 1;
+  }
 
   /*
    * CREATE TEMOTO WS PACKAGE DIRECTORY STRUCTURE
@@ -41,24 +99,34 @@ int main(int argc, char **argv)
    * GENERATE THE CONTENT
    */
   std::cout << "* Parsing arguments" << std::endl;
-  t_cmakelists.setArgument("temoto_ws_name", temoto_ws_name);
-  t_packagexml.setArgument("temoto_ws_name", temoto_ws_name);
-  t_temoto_launch.setArgument("temoto_ws_name", temoto_ws_name);
-  t_aa_launch.setArgument("temoto_ws_name", temoto_ws_name);
-  t_components.setArgument("temoto_ws_name", temoto_ws_name);
-  t_console_conf.setArgument("temoto_ws_name", temoto_ws_name);
+  TemplateArguments ws_args;
+  ws_args.set("temoto_ws_name", temoto_ws_name);
 
   /*
    * SAVE THE CONTENT
    */
   std::cout << "* Generating the package content" << std::endl;
-  t_cmakelists.processAndSaveTemplate(temoto_ws_package_path, "CMakeLists");
-  t_packagexml.processAndSaveTemplate(temoto_ws_package_path, "package");
-  t_temoto_launch.processAndSaveTemplate(temoto_ws_package_path + "/launch/", "temoto");
-  t_aa_launch.processAndSaveTemplate(temoto_ws_package_path + "/launch/", "action_assistant");
-  t_components.processAndSaveTemplate(temoto_ws_package_path + "/config/", "components");
-  t_console_conf.processAndSaveTemplate(temoto_ws_package_path + "/config/", "console");
-  
+  saveTemplate(t_cmakelists, ws_args, temoto_ws_package_path, "CMakeLists");
+  saveTemplate(t_packagexml, ws_args, temoto_ws_package_path, "package");
+  saveTemplate(t_temoto_launch, ws_args, temoto_ws_package_path + "/launch/", "temoto");
+  saveTemplate(t_aa_launch, ws_args, temoto_ws_package_path + "/launch/", "action_assistant");
+  saveTemplate(t_components, ws_args, temoto_ws_package_path + "/config/", "components");
+  saveTemplate(t_console_conf, ws_args, temoto_ws_package_path + "/config/", "console");
+
+  /*
+   * GENERATE THE ACTIONS SUPERBUILD PACKAGE
+   */
+  if (superbuild)
+  {
+    std::cout << "* Generating the actions superbuild package" << std::endl;
+    boost::filesystem::create_directories(temoto_ws_superbuild_path);
+    saveTemplate(t_superbuild_cmakelists, ws_args, temoto_ws_superbuild_path, "CMakeLists");
+    saveTemplate(t_superbuild_packagexml, ws_args, temoto_ws_superbuild_path, "package");
+
+    // The actions are built by the superbuild package, so catkin must not build them on their own
+    std::ofstream catkin_ignore_file(temoto_ws_path + "temoto_actions/CATKIN_IGNORE");
+    catkin_ignore_file.close();
+  }
 
   std::cout << "* Finished generating a TeMoto workspace '" << temoto_ws_name 
             << "' to " << temoto_ws_path << std::endl;